@@ -0,0 +1,102 @@
+#include "warp/log/logger.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <format>
+#include <new>
+#include <string>
+#include <string_view>
+
+namespace
+{
+   std::atomic<size_t> allocations{0};
+}
+
+// Counts every heap allocation made by the process
+void* operator new(std::size_t size)
+{
+   allocations.fetch_add(1, std::memory_order_relaxed);
+   if (void* p = std::malloc(size == 0 ? 1 : size)) return p;
+   throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+   std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+   std::free(p);
+}
+
+namespace
+{
+   // What the *WithHeader paths did before formatting in one pass
+   std::string NestedFormat(std::string_view header, std::string_view path, int ratingKey)
+   {
+      return std::format("{}: {}", header, std::format("No rating key {} found for path {}", ratingKey, path));
+   }
+
+   template <typename Func>
+   void Run(std::string_view name, int iterations, Func&& func)
+   {
+      size_t checksum{0};
+      const size_t allocationsBefore = allocations.load(std::memory_order_relaxed);
+      const auto start = std::chrono::steady_clock::now();
+      for (int i = 0; i < iterations; ++i)
+      {
+         checksum += func(i);
+      }
+      const auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start);
+      const auto perLine = elapsed.count() / static_cast<double>(iterations);
+      const auto allocationsPerLine = static_cast<double>(allocations.load(std::memory_order_relaxed) - allocationsBefore) / iterations;
+
+      std::printf("%-28s %10.1f ns/line %6.2f allocations/line (checksum %zu)\n",
+                  std::string(name).c_str(), perLine, allocationsPerLine, checksum);
+   }
+}
+
+int main()
+{
+   constexpr int ITERATIONS{1'000'000};
+
+   // Long enough that neither string fits the small string buffer
+   const std::string_view header = "PlexApi(serverA) - GetItemInfoByPathWithToken";
+   const std::string_view path = "/media/tv/Some Show/Season 01/Some Show - S01E01 - Pilot.mkv";
+
+   Run("nested std::format", ITERATIONS, [&](int i) {
+      return NestedFormat(header, path, i).size();
+   });
+
+   std::string buffer;
+   Run("single pass, reused buffer", ITERATIONS, [&](int i) {
+      buffer.clear();
+      warp::detail::FormatLogMessage(buffer, &header, "No rating key {} found for path {}", i, path);
+      return buffer.size();
+   });
+
+   // The whole logging path without any sink, so the workers drop every message.
+   // Times the calling thread, including waits while the queue is full.
+   warp::LogConfig config;
+   config.level = warp::LogType::INFO;
+   config.console = false;
+   warp::Logger::Configure(config);
+   auto& logger = warp::Logger::Instance();
+
+   Run("Logger, formatted", ITERATIONS, [&](int i) {
+      logger.InfoWithHeader(header, "No rating key {} found for path {}", i, path);
+      return size_t{1};
+   });
+
+   logger.SetDeferredFormatting(true);
+   Run("Logger, deferred", ITERATIONS, [&](int i) {
+      logger.InfoWithHeader(header, "No rating key {} found for path {}", i, path);
+      return size_t{1};
+   });
+
+   logger.Shutdown();
+   return 0;
+}
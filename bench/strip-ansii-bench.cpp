@@ -0,0 +1,94 @@
+#include "warp/log/log-types.h"
+#include "warp/log/log-utils.h"
+#include "warp/utils.h"
+
+#include <chrono>
+#include <cstdio>
+#include <format>
+#include <regex>
+#include <string>
+#include <vector>
+
+namespace
+{
+   // The regex implementation StripAnsiiCharacters used to have
+   std::string RegexStripAnsiiCharacters(const std::string& data)
+   {
+      const std::regex ansii(R"(\x1B(?:[@-Z\\-_]|\[[0-?]*[ -/]*[@-~]))");
+      return std::regex_replace(data, ansii, "");
+   }
+
+   // GetTag embeds style codes now, render it with the ansi codes a console line carries
+   std::string GetAnsiiTag(std::string_view tag, std::string_view value)
+   {
+      return std::format("{}{}{}[{}]", warp::ANSI_CODE_TAG, tag, warp::ANSI_CODE_LOG, value);
+   }
+
+   std::vector<std::string> BuildLogLines()
+   {
+      const auto header = std::format("{}PlexApi{}(serverA)", warp::ANSI_CODE_PLEX, warp::ANSI_CODE_LOG);
+
+      std::vector<std::string> lines;
+      for (int i = 0; i < 1000; ++i)
+      {
+         lines.push_back(std::format("{}: {} - No rating key found for path {}",
+                                     header, "GetItemInfoByPathWithToken",
+                                     GetAnsiiTag("path", std::format("/media/tv/Show {}/Season 01/Episode {}.mkv", i, i))));
+         lines.push_back(std::format("{}: Marked {} as watched {} {}",
+                                     header, GetAnsiiTag("ratingKey", std::to_string(i)),
+                                     GetAnsiiTag("user", "someone"), GetAnsiiTag("progress", "97.5")));
+         lines.push_back(std::format("{}: Keeping stale collection data due to fetch failures", header));
+         lines.push_back(warp::GetTag("plain", i));
+      }
+      return lines;
+   }
+
+   template <typename Func>
+   void Run(std::string_view name, const std::vector<std::string>& lines, int iterations, Func&& func)
+   {
+      size_t checksum{0};
+      const auto start = std::chrono::steady_clock::now();
+      for (int i = 0; i < iterations; ++i)
+      {
+         for (const auto& line : lines)
+         {
+            checksum += func(line);
+         }
+      }
+      const auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start);
+      const auto perLine = elapsed.count() / static_cast<double>(lines.size() * iterations);
+
+      std::printf("%-28s %10.1f ns/line (checksum %zu)\n", std::string(name).c_str(), perLine, checksum);
+   }
+}
+
+int main()
+{
+   const auto lines = BuildLogLines();
+   constexpr int ITERATIONS{50};
+
+   for (const auto& line : lines)
+   {
+      if (RegexStripAnsiiCharacters(line) != warp::StripAnsiiCharacters(line))
+      {
+         std::printf("Mismatch for line: %s\n", line.c_str());
+         return 1;
+      }
+   }
+
+   Run("regex", lines, ITERATIONS, [](const std::string& line) {
+      return RegexStripAnsiiCharacters(line).size();
+   });
+
+   Run("state machine", lines, ITERATIONS, [](const std::string& line) {
+      return warp::StripAnsiiCharacters(line).size();
+   });
+
+   std::string buffer;
+   Run("state machine (buffer)", lines, ITERATIONS, [&buffer](const std::string& line) {
+      buffer.resize(line.size());
+      return warp::StripAnsiiCharacters(std::string_view(line), buffer.data());
+   });
+
+   return 0;
+}
@@ -8,6 +8,29 @@
 #include <optional>
 #include <string_view>
 
+// Base log macros that remove the call when the level is below WARP_LOG_ACTIVE_LEVEL.
+// Otherwise the arguments are only evaluated once the base object's level check passes.
+#define WARP_BASE_LOG_IF_ACTIVE(base, level, call) WARP_LOG_IF_ENABLED(level, (base).ShouldLog(level), call)
+
+#define WARP_BASE_LOG_TRACE(base, ...) WARP_BASE_LOG_IF_ACTIVE(base, ::warp::LogType::TRACE, (base).LogTrace(__VA_ARGS__))
+#define WARP_BASE_LOG_INFO(base, ...) WARP_BASE_LOG_IF_ACTIVE(base, ::warp::LogType::INFO, (base).LogInfo(__VA_ARGS__))
+#define WARP_BASE_LOG_WARNING(base, ...) WARP_BASE_LOG_IF_ACTIVE(base, ::warp::LogType::WARN, (base).LogWarning(__VA_ARGS__))
+#define WARP_BASE_LOG_ERROR(base, ...) WARP_BASE_LOG_IF_ACTIVE(base, ::warp::LogType::ERR, (base).LogError(__VA_ARGS__))
+
+// Sampled trace for per item loops, see WARP_LOG_SAMPLED
+#define WARP_BASE_LOG_TRACE_SAMPLED(base, sampling, ...) \
+   do \
+   { \
+      if constexpr (::warp::IsLogLevelActive(::warp::LogType::TRACE)) \
+      { \
+         if ((base).IsLevelEnabled(::warp::LogType::TRACE)) \
+         { \
+            static ::warp::LogSampler warpLogSampler{sampling}; \
+            (base).LogTraceSampled(warpLogSampler, __VA_ARGS__); \
+         } \
+      } \
+   } while (false)
+
 namespace warp
 {
    class Base
@@ -18,28 +41,53 @@ namespace warp
            std::optional<std::string_view> classExtra);
       virtual ~Base() = default;
 
+      // Returns if a message at the level would be logged or recorded for the backtrace.
+      // Uses the level set for this component, see Logger::SetComponentLevel, or the global level.
+      [[nodiscard]] bool ShouldLog(LogType level) const
+      {
+         return Logger::IsEnabled(level, *componentLevel_) || Logger::IsBacktraceEnabled();
+      }
+
+      // Returns if a message at the level would be written, without the backtrace
+      [[nodiscard]] bool IsLevelEnabled(LogType level) const
+      {
+         return Logger::IsEnabled(level, *componentLevel_);
+      }
+
       template<typename... Args>
       void LogTrace(std::format_string<Args...> fmt, Args &&...args)
       {
-         log::TraceWithHeader(header_, fmt, std::forward<Args>(args)...);
+         LogChecked<LogType::TRACE>(fmt, std::forward<Args>(args)...);
+      }
+
+      template<typename... Args>
+      void LogTraceSampled(LogSampler& sampler, std::format_string<Args...> fmt, Args &&...args)
+      {
+         if constexpr (IsLogLevelActive(LogType::TRACE))
+         {
+            if (IsLevelEnabled(LogType::TRACE))
+            {
+               Logger::Instance().LogSampledWithHeader(LogType::TRACE, header_, sampler, fmt, std::forward<Args>(args)...);
+            }
+         }
       }
 
       template<typename... Args>
       void LogInfo(std::format_string<Args...> fmt, Args &&...args)
       {
-         log::InfoWithHeader(header_, fmt, std::forward<Args>(args)...);
+         LogChecked<LogType::INFO>(fmt, std::forward<Args>(args)...);
       }
 
       template<typename... Args>
       void LogWarning(std::format_string<Args...> fmt, Args&&... args)
       {
-         log::WarningWithHeader(header_, fmt, std::forward<Args>(args)...);
+         LogChecked<LogType::WARN>(fmt, std::forward<Args>(args)...);
       }
 
       template<typename... Args>
       void LogError(std::format_string<Args...> fmt, Args &&...args)
       {
-         log::ErrorWithHeader(header_, fmt, std::forward<Args>(args)...);
+         LogChecked<LogType::ERR>(fmt, std::forward<Args>(args)...);
       }
 
       template<typename... Args>
@@ -65,6 +113,23 @@ namespace warp
       }
 
    private:
+      template<LogType Level, typename... Args>
+      void LogChecked(std::format_string<Args...> fmt, Args &&...args)
+      {
+         if constexpr (IsLogLevelActive(Level))
+         {
+            if (Logger::IsEnabled(Level, *componentLevel_))
+            {
+               Logger::Instance().LogWithHeader(Level, header_, fmt, std::forward<Args>(args)...);
+            }
+            else if (Logger::IsBacktraceEnabled())
+            {
+               Logger::Instance().CaptureWithHeader(Level, header_, fmt, std::forward<Args>(args)...);
+            }
+         }
+      }
+
       std::string header_;
+      const Logger::ComponentLevel* componentLevel_{nullptr};
    };
 }
\ No newline at end of file
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "warp/log/log-types.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define WARP_LOG_HAS_TSC 1
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#else
+#define WARP_LOG_HAS_TSC 0
+#endif
+
+namespace warp
+{
+   // Time source of log records. With LogClockSource::TSC a record is stamped with
+   // the time stamp counter, which the backend converts to wall time with a
+   // calibration against the system clock that is refreshed every second. Only
+   // deferred records carry ticks, see LogConfig::clock.
+   class LogClock
+   {
+   public:
+      struct Stamp
+      {
+         int64_t value{0};
+
+         // The value counts TSC ticks instead of nanoseconds since the epoch
+         bool ticks{false};
+      };
+
+      // Returns false if the TSC was asked for but is not invariant or not available,
+      // the system clock stays in use then
+      static bool SetSource(LogClockSource source);
+
+      [[nodiscard]] static LogClockSource GetSource()
+      {
+         return tsc_.load(std::memory_order_relaxed) ? LogClockSource::TSC : LogClockSource::SYSTEM;
+      }
+
+      static Stamp Now()
+      {
+#if WARP_LOG_HAS_TSC
+         if (tsc_.load(std::memory_order_relaxed)) return {static_cast<int64_t>(__rdtsc()), true};
+#endif
+         return {std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count(), false};
+      }
+
+      // Returns the stamp in nanoseconds since the epoch
+      static int64_t ToNanoseconds(const Stamp& stamp)
+      {
+         return stamp.ticks ? TicksToNanoseconds(stamp.value) : stamp.value;
+      }
+
+      static int64_t TicksToNanoseconds(int64_t ticks);
+
+   private:
+      static inline std::atomic_bool tsc_{false};
+   };
+}
\ No newline at end of file
@@ -0,0 +1,351 @@
+#pragma once
+
+#include "warp/log/log-clock.h"
+#include "warp/log/log-types.h"
+
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <format>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+
+namespace warp
+{
+   // Wire tag written in front of every deferred argument so a record can be
+   // decoded without knowing the types of the call that produced it.
+   enum class DeferredArgTag : uint8_t
+   {
+      BOOL,
+      CHAR,
+      INT8,
+      INT16,
+      INT32,
+      INT64,
+      UINT8,
+      UINT16,
+      UINT32,
+      UINT64,
+      FLOAT,
+      DOUBLE,
+      STRING
+   };
+
+   template <typename T>
+   concept DeferredStringArg = std::convertible_to<const T&, std::string_view>;
+
+   template <typename T>
+   concept DeferredFixedArg = std::same_as<T, bool> || std::same_as<T, char>
+      || std::same_as<T, float> || std::same_as<T, double>
+      || (std::is_integral_v<T> && !std::same_as<T, wchar_t> && !std::same_as<T, char8_t>
+          && !std::same_as<T, char16_t> && !std::same_as<T, char32_t> && sizeof(T) <= 8);
+
+   // Arguments that can be captured as raw bytes on the calling thread and formatted later
+   template <typename T>
+   concept DeferrableArg = DeferredFixedArg<std::remove_cvref_t<T>> || DeferredStringArg<std::remove_cvref_t<T>>;
+
+   template <typename T>
+   using DeferredStorageType = std::conditional_t<DeferredStringArg<std::remove_cvref_t<T>>,
+                                                  std::string_view,
+                                                  std::remove_cvref_t<T>>;
+
+   template <typename T>
+   consteval DeferredArgTag GetDeferredArgTag()
+   {
+      if constexpr (std::same_as<T, bool>) return DeferredArgTag::BOOL;
+      else if constexpr (std::same_as<T, char>) return DeferredArgTag::CHAR;
+      else if constexpr (std::same_as<T, float>) return DeferredArgTag::FLOAT;
+      else if constexpr (std::same_as<T, double>) return DeferredArgTag::DOUBLE;
+      else if constexpr (std::is_signed_v<T>)
+      {
+         if constexpr (sizeof(T) == 1) return DeferredArgTag::INT8;
+         else if constexpr (sizeof(T) == 2) return DeferredArgTag::INT16;
+         else if constexpr (sizeof(T) == 4) return DeferredArgTag::INT32;
+         else return DeferredArgTag::INT64;
+      }
+      else
+      {
+         if constexpr (sizeof(T) == 1) return DeferredArgTag::UINT8;
+         else if constexpr (sizeof(T) == 2) return DeferredArgTag::UINT16;
+         else if constexpr (sizeof(T) == 4) return DeferredArgTag::UINT32;
+         else return DeferredArgTag::UINT64;
+      }
+   }
+
+   // Formats the encoded arguments of a record with the format string it was captured with
+   using DeferredFormatFn = void (*)(std::string_view fmt, const std::byte* args, std::string& out);
+
+   // Fixed part of every record in a deferred ring. The header text and the
+   // encoded arguments follow it directly.
+   struct DeferredRecord
+   {
+      static constexpr uint8_t FLAG_HEADER{0x01};
+      static constexpr uint8_t FLAG_TSC{0x02};
+
+      uint32_t size{0};
+      LogType level{LogType::INFO};
+      uint8_t flags{0};
+      uint8_t argCount{0};
+      uint16_t headerLength{0};
+      int64_t time{0};
+      const char* fmt{nullptr};
+      uint32_t fmtLength{0};
+      DeferredFormatFn format{nullptr};
+
+      // Capture time in nanoseconds since the epoch, converted from TSC ticks with FLAG_TSC
+      [[nodiscard]] int64_t TimeNanoseconds() const
+      {
+         return LogClock::ToNanoseconds({time, (flags & FLAG_TSC) != 0});
+      }
+
+      [[nodiscard]] const std::byte* Data() const
+      {
+         return reinterpret_cast<const std::byte*>(this) + sizeof(DeferredRecord);
+      }
+
+      [[nodiscard]] std::string_view Header() const
+      {
+         return {reinterpret_cast<const char*>(Data()), headerLength};
+      }
+
+      [[nodiscard]] std::string_view Format() const
+      {
+         return {fmt, fmtLength};
+      }
+
+      [[nodiscard]] const std::byte* Args() const
+      {
+         return Data() + headerLength;
+      }
+   };
+
+   static_assert(std::is_trivially_copyable_v<DeferredRecord>);
+
+   // Single producer / single consumer byte ring. Each producing thread owns one
+   // ring and the logging backend drains all of them.
+   class DeferredRing
+   {
+   public:
+      static constexpr size_t ALIGNMENT{alignof(DeferredRecord)};
+
+      explicit DeferredRing(size_t capacity)
+         : capacity_(std::bit_ceil(capacity))
+         , buffer_(std::make_unique<std::byte[]>(capacity_))
+      {
+      }
+
+      // Largest record the ring will ever accept
+      [[nodiscard]] size_t MaxRecordSize() const
+      {
+         return capacity_ / 2;
+      }
+
+      // Returns contiguous space for a record of the given size or nullptr if the
+      // ring does not currently have room. The record is published by Commit.
+      [[nodiscard]] std::byte* Prepare(size_t size)
+      {
+         size = AlignSize(size);
+         if (size > MaxRecordSize()) return nullptr;
+
+         const auto head = head_.load(std::memory_order_relaxed);
+         const auto offset = head & (capacity_ - 1);
+         const auto padding = (offset + size > capacity_) ? capacity_ - offset : 0;
+
+         if (head + padding + size - cachedTail_ > capacity_)
+         {
+            cachedTail_ = tail_.load(std::memory_order_acquire);
+            if (head + padding + size - cachedTail_ > capacity_) return nullptr;
+         }
+
+         if (padding > 0)
+         {
+            // Mark the remainder of the buffer as unused so the reader wraps
+            constexpr uint32_t PADDING{0};
+            std::memcpy(buffer_.get() + offset, &PADDING, sizeof(PADDING));
+            pendingHead_ = head + padding;
+            return buffer_.get();
+         }
+
+         pendingHead_ = head;
+         return buffer_.get() + offset;
+      }
+
+      void Commit(size_t size)
+      {
+         head_.store(pendingHead_ + AlignSize(size), std::memory_order_release);
+      }
+
+      // Consumer side: returns the next record or nullptr when the ring is empty
+      [[nodiscard]] const DeferredRecord* Peek()
+      {
+         auto tail = tail_.load(std::memory_order_relaxed);
+         const auto head = head_.load(std::memory_order_acquire);
+         if (tail == head) return nullptr;
+
+         auto* record = reinterpret_cast<const DeferredRecord*>(buffer_.get() + (tail & (capacity_ - 1)));
+         if (record->size == 0)
+         {
+            // Padding up to the end of the buffer
+            tail += capacity_ - (tail & (capacity_ - 1));
+            tail_.store(tail, std::memory_order_release);
+            if (tail == head) return nullptr;
+            record = reinterpret_cast<const DeferredRecord*>(buffer_.get());
+         }
+         return record;
+      }
+
+      void Pop(const DeferredRecord* record)
+      {
+         tail_.fetch_add(AlignSize(record->size), std::memory_order_release);
+      }
+
+      [[nodiscard]] bool Empty() const
+      {
+         return tail_.load(std::memory_order_acquire) == head_.load(std::memory_order_acquire);
+      }
+
+      // Set by the owning thread on exit so the backend can release the ring once drained
+      std::atomic_bool closed{false};
+
+   private:
+      static constexpr size_t AlignSize(size_t size)
+      {
+         return (size + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+      }
+
+      size_t capacity_;
+      std::unique_ptr<std::byte[]> buffer_;
+
+      alignas(64) std::atomic<size_t> head_{0};
+      size_t pendingHead_{0};
+      size_t cachedTail_{0};
+
+      alignas(64) std::atomic<size_t> tail_{0};
+   };
+
+   namespace detail
+   {
+      template <typename T>
+      inline size_t DeferredArgSize(const T& value)
+      {
+         using Type = std::remove_cvref_t<T>;
+         if constexpr (DeferredStringArg<Type>)
+         {
+            return 1 + sizeof(uint32_t) + std::string_view(value).size();
+         }
+         else
+         {
+            return 1 + sizeof(Type);
+         }
+      }
+
+      template <typename T>
+      inline std::byte* WriteDeferredArg(std::byte* out, const T& value)
+      {
+         using Type = std::remove_cvref_t<T>;
+         if constexpr (DeferredStringArg<Type>)
+         {
+            *out++ = static_cast<std::byte>(DeferredArgTag::STRING);
+            std::string_view text(value);
+            auto length = static_cast<uint32_t>(text.size());
+            std::memcpy(out, &length, sizeof(length));
+            std::memcpy(out + sizeof(length), text.data(), text.size());
+            return out + sizeof(length) + text.size();
+         }
+         else
+         {
+            *out++ = static_cast<std::byte>(GetDeferredArgTag<Type>());
+            std::memcpy(out, &value, sizeof(Type));
+            return out + sizeof(Type);
+         }
+      }
+
+      template <typename T>
+      inline DeferredStorageType<T> ReadDeferredArg(const std::byte*& in)
+      {
+         using Storage = DeferredStorageType<T>;
+
+         // Skip the tag, the type is known statically here
+         ++in;
+         if constexpr (std::same_as<Storage, std::string_view>)
+         {
+            uint32_t length{0};
+            std::memcpy(&length, in, sizeof(length));
+            std::string_view text(reinterpret_cast<const char*>(in + sizeof(length)), length);
+            in += sizeof(length) + length;
+            return text;
+         }
+         else
+         {
+            Storage value;
+            std::memcpy(&value, in, sizeof(Storage));
+            in += sizeof(Storage);
+            return value;
+         }
+      }
+
+      template <typename... Args>
+      void FormatDeferredArgs(std::string_view fmt, const std::byte* args, std::string& out)
+      {
+         // Braced initialization guarantees the arguments are read in order
+         std::tuple<DeferredStorageType<Args>...> values{ReadDeferredArg<Args>(args)...};
+         std::apply([&fmt, &out](auto&... value) {
+            std::vformat_to(std::back_inserter(out), fmt, std::make_format_args(value...));
+         }, values);
+      }
+
+      template <typename... Args>
+      inline size_t DeferredRecordSize(const std::string_view* header, const Args&... args)
+      {
+         const size_t headerLength = header != nullptr ? header->size() : 0u;
+         return sizeof(DeferredRecord) + headerLength + (size_t{0} + ... + DeferredArgSize(args));
+      }
+
+      // Captures a log call into the ring. Returns false if the ring has no room.
+      template <typename... Args>
+      bool WriteDeferredRecord(DeferredRing& ring,
+                               size_t size,
+                               LogType level,
+                               const std::string_view* header,
+                               std::string_view fmt,
+                               const Args&... args)
+      {
+         const size_t headerLength = header != nullptr ? header->size() : 0u;
+
+         auto* out = ring.Prepare(size);
+         if (out == nullptr) return false;
+
+         DeferredRecord record;
+         record.size = static_cast<uint32_t>(size);
+         record.level = level;
+         const auto stamp = LogClock::Now();
+         record.flags = static_cast<uint8_t>((header != nullptr ? DeferredRecord::FLAG_HEADER : 0) | (stamp.ticks ? DeferredRecord::FLAG_TSC : 0));
+         record.argCount = static_cast<uint8_t>(sizeof...(Args));
+         record.headerLength = static_cast<uint16_t>(headerLength);
+         record.time = stamp.value;
+         record.fmt = fmt.data();
+         record.fmtLength = static_cast<uint32_t>(fmt.size());
+         record.format = &FormatDeferredArgs<Args...>;
+         std::memcpy(out, &record, sizeof(record));
+
+         auto* data = out + sizeof(DeferredRecord);
+         if (headerLength > 0)
+         {
+            std::memcpy(data, header->data(), headerLength);
+            data += headerLength;
+         }
+         ((data = WriteDeferredArg(data, args)), ...);
+
+         ring.Commit(size);
+         return true;
+      }
+   }
+}
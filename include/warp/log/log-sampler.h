@@ -0,0 +1,99 @@
+#pragma once
+
+#include "warp/log/log-types.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <limits>
+
+namespace warp
+{
+   // Decides which calls of one call site are logged, see WARP_LOG_TRACE_SAMPLED.
+   // Calls that are not logged are counted and the count is added to the next line.
+   class LogSampler
+   {
+   public:
+      explicit LogSampler(const LogSampling& sampling)
+         : sampling_(sampling)
+         , threshold_(GetThreshold(sampling.probability))
+      {
+      }
+
+      // Returns if this call is logged
+      bool Sample()
+      {
+         if (Pass()) return true;
+
+         skipped_.fetch_add(1u, std::memory_order_relaxed);
+         totalSkipped_.fetch_add(1u, std::memory_order_relaxed);
+         return false;
+      }
+
+      // Returns the calls skipped since the last logged one
+      uint64_t TakeSkipped()
+      {
+         return skipped_.exchange(0u, std::memory_order_relaxed);
+      }
+
+      [[nodiscard]] uint64_t TotalSkipped() const
+      {
+         return totalSkipped_.load(std::memory_order_relaxed);
+      }
+
+   private:
+      bool Pass()
+      {
+         switch (sampling_.mode)
+         {
+            case LogSampling::Mode::EVERY_NTH:
+               return count_.fetch_add(1u, std::memory_order_relaxed) % sampling_.every == 0u;
+
+            case LogSampling::Mode::PROBABILITY:
+               return NextRandom() < threshold_ || threshold_ == std::numeric_limits<uint64_t>::max();
+
+            case LogSampling::Mode::PER_SECOND:
+            {
+               const auto second = std::chrono::duration_cast<std::chrono::seconds>(
+                  std::chrono::steady_clock::now().time_since_epoch()).count();
+
+               // Whoever moves the window on resets its count, racing calls may log one extra line
+               auto window = window_.load(std::memory_order_relaxed);
+               if (window != second && window_.compare_exchange_strong(window, second, std::memory_order_relaxed))
+               {
+                  count_.store(0u, std::memory_order_relaxed);
+               }
+               return count_.fetch_add(1u, std::memory_order_relaxed) < sampling_.perSecond;
+            }
+         }
+         return true;
+      }
+
+      static uint64_t GetThreshold(double probability)
+      {
+         if (probability >= 1.0) return std::numeric_limits<uint64_t>::max();
+         if (probability <= 0.0) return 0u;
+         return static_cast<uint64_t>(probability * 18446744073709551616.0);
+      }
+
+      // splitmix64 per thread, good enough to spread the samples
+      static uint64_t NextRandom()
+      {
+         thread_local uint64_t state = static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count())
+            ^ reinterpret_cast<uintptr_t>(&state);
+
+         uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+         z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+         z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+         return z ^ (z >> 31);
+      }
+
+      LogSampling sampling_;
+      uint64_t threshold_;
+
+      std::atomic<uint64_t> count_{0};
+      std::atomic<int64_t> window_{0};
+      std::atomic<uint64_t> skipped_{0};
+      std::atomic<uint64_t> totalSkipped_{0};
+   };
+}
\ No newline at end of file
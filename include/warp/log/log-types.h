@@ -1,8 +1,24 @@
 #pragma once
 
+#include <chrono>
 #include <cstdint>
+#include <filesystem>
+#include <optional>
 #include <string>
 #include <string_view>
+#include <vector>
+
+// Numeric values of the log levels for use with WARP_LOG_ACTIVE_LEVEL
+#define WARP_LOG_LEVEL_TRACE 0
+#define WARP_LOG_LEVEL_INFO 1
+#define WARP_LOG_LEVEL_WARN 2
+#define WARP_LOG_LEVEL_ERR 3
+#define WARP_LOG_LEVEL_CRITICAL 4
+
+// Log calls below this level are removed at compile time
+#ifndef WARP_LOG_ACTIVE_LEVEL
+#define WARP_LOG_ACTIVE_LEVEL WARP_LOG_LEVEL_TRACE
+#endif
 
 namespace warp
 {
@@ -25,11 +41,115 @@ namespace warp
    inline const std::string ANSI_CODE_TAUTULLI{std::format("{}136{}", ANSI_CODE_START, ANSI_CODE_END)};
    inline const std::string ANSI_CODE_JELLYSTAT{std::format("{}63{}", ANSI_CODE_START, ANSI_CODE_END)};
 
+   // Styles that can be attached to parts of a log message. The console renders
+   // them as ansi colors while every other sink writes the plain text.
+   enum class LogStyle : uint8_t
+   {
+      LOG,
+      HEADER,
+      INFO,
+      WARNING,
+      ERR,
+      CRITICAL,
+      DEFAULT,
+      TAG,
+      STANDOUT,
+      PLEX,
+      EMBY,
+      TAUTULLI,
+      JELLYSTAT
+   };
+
+   // A style change inside a message is encoded as the marker followed by one
+   // printable character identifying the style
+   inline constexpr char STYLE_MARKER{'\x1F'};
+   inline constexpr char STYLE_ID_BASE{'A'};
+
+   namespace detail
+   {
+      template <LogStyle Style>
+      inline constexpr char STYLE_CODE_CHARS[]{STYLE_MARKER, static_cast<char>(STYLE_ID_BASE + static_cast<char>(Style)), '\0'};
+   }
+
+   inline constexpr std::string_view STYLE_CODE_LOG{detail::STYLE_CODE_CHARS<LogStyle::LOG>, 2};
+   inline constexpr std::string_view STYLE_CODE_HEADER{detail::STYLE_CODE_CHARS<LogStyle::HEADER>, 2};
+   inline constexpr std::string_view STYLE_CODE_INFO{detail::STYLE_CODE_CHARS<LogStyle::INFO>, 2};
+   inline constexpr std::string_view STYLE_CODE_WARNING{detail::STYLE_CODE_CHARS<LogStyle::WARNING>, 2};
+   inline constexpr std::string_view STYLE_CODE_ERROR{detail::STYLE_CODE_CHARS<LogStyle::ERR>, 2};
+   inline constexpr std::string_view STYLE_CODE_CRITICAL{detail::STYLE_CODE_CHARS<LogStyle::CRITICAL>, 2};
+   inline constexpr std::string_view STYLE_CODE_DEFAULT{detail::STYLE_CODE_CHARS<LogStyle::DEFAULT>, 2};
+   inline constexpr std::string_view STYLE_CODE_TAG{detail::STYLE_CODE_CHARS<LogStyle::TAG>, 2};
+   inline constexpr std::string_view STYLE_CODE_STANDOUT{detail::STYLE_CODE_CHARS<LogStyle::STANDOUT>, 2};
+   inline constexpr std::string_view STYLE_CODE_PLEX{detail::STYLE_CODE_CHARS<LogStyle::PLEX>, 2};
+   inline constexpr std::string_view STYLE_CODE_EMBY{detail::STYLE_CODE_CHARS<LogStyle::EMBY>, 2};
+   inline constexpr std::string_view STYLE_CODE_TAUTULLI{detail::STYLE_CODE_CHARS<LogStyle::TAUTULLI>, 2};
+   inline constexpr std::string_view STYLE_CODE_JELLYSTAT{detail::STYLE_CODE_CHARS<LogStyle::JELLYSTAT>, 2};
+
+   // Returns the style code to embed in a log message for the style
+   constexpr std::string_view GetStyleCode(LogStyle style)
+   {
+      switch (style)
+      {
+         case LogStyle::HEADER:
+            return STYLE_CODE_HEADER;
+         case LogStyle::INFO:
+            return STYLE_CODE_INFO;
+         case LogStyle::WARNING:
+            return STYLE_CODE_WARNING;
+         case LogStyle::ERR:
+            return STYLE_CODE_ERROR;
+         case LogStyle::CRITICAL:
+            return STYLE_CODE_CRITICAL;
+         case LogStyle::DEFAULT:
+            return STYLE_CODE_DEFAULT;
+         case LogStyle::TAG:
+            return STYLE_CODE_TAG;
+         case LogStyle::STANDOUT:
+            return STYLE_CODE_STANDOUT;
+         case LogStyle::PLEX:
+            return STYLE_CODE_PLEX;
+         case LogStyle::EMBY:
+            return STYLE_CODE_EMBY;
+         case LogStyle::TAUTULLI:
+            return STYLE_CODE_TAUTULLI;
+         case LogStyle::JELLYSTAT:
+            return STYLE_CODE_JELLYSTAT;
+         default:
+            return STYLE_CODE_LOG;
+      }
+   }
+
+   // Typed key/value fields are embedded the same way. A field is the marker and
+   // its type, the key, the marker and FIELD_VALUE, the value, the marker and FIELD_END.
+   // The console renders it as key[value], structured sinks as a typed field.
+   enum class LogFieldType : char
+   {
+      STRING = 's',
+      INT = 'i',
+      UINT = 'u',
+      FLOAT = 'f',
+      BOOL = 'b'
+   };
+
+   inline constexpr char FIELD_VALUE{'='};
+   inline constexpr char FIELD_END{';'};
+
+   namespace detail
+   {
+      template <char Id>
+      inline constexpr char FIELD_CODE_CHARS[]{STYLE_MARKER, Id, '\0'};
+   }
+
+   template <LogFieldType Type>
+   inline constexpr std::string_view FIELD_CODE_START{detail::FIELD_CODE_CHARS<static_cast<char>(Type)>, 2};
+   inline constexpr std::string_view FIELD_CODE_VALUE{detail::FIELD_CODE_CHARS<FIELD_VALUE>, 2};
+   inline constexpr std::string_view FIELD_CODE_END{detail::FIELD_CODE_CHARS<FIELD_END>, 2};
+
    inline const std::string ANSI_FORMATTED_UNKNOWN("Unknown Server");
-   inline const std::string ANSI_FORMATTED_PLEX(std::format("{}Plex{}", ANSI_CODE_PLEX, ANSI_CODE_LOG));
-   inline const std::string ANSI_FORMATTED_EMBY(std::format("{}Emby{}", ANSI_CODE_EMBY, ANSI_CODE_LOG));
-   inline const std::string ANSI_FORMATTED_TAUTULLI(std::format("{}Tautulli{}", ANSI_CODE_TAUTULLI, ANSI_CODE_LOG));
-   inline const std::string ANSI_FORMATTED_JELLYSTAT(std::format("{}Jellystat{}", ANSI_CODE_JELLYSTAT, ANSI_CODE_LOG));
+   inline const std::string ANSI_FORMATTED_PLEX(std::format("{}Plex{}", STYLE_CODE_PLEX, STYLE_CODE_LOG));
+   inline const std::string ANSI_FORMATTED_EMBY(std::format("{}Emby{}", STYLE_CODE_EMBY, STYLE_CODE_LOG));
+   inline const std::string ANSI_FORMATTED_TAUTULLI(std::format("{}Tautulli{}", STYLE_CODE_TAUTULLI, STYLE_CODE_LOG));
+   inline const std::string ANSI_FORMATTED_JELLYSTAT(std::format("{}Jellystat{}", STYLE_CODE_JELLYSTAT, STYLE_CODE_LOG));
 
    enum class LogType
    {
@@ -40,11 +160,205 @@ namespace warp
       CRITICAL
    };
 
+   inline constexpr LogType ACTIVE_LOG_LEVEL{static_cast<LogType>(WARP_LOG_ACTIVE_LEVEL)};
+
+   // Returns if log calls at the level are compiled in
+   constexpr bool IsLogLevelActive(LogType level)
+   {
+      return level >= ACTIVE_LOG_LEVEL;
+   }
+
+   // What a log call does when the async queue is full
+   enum class LogOverflowPolicy
+   {
+      BLOCK,            // Wait until the logging worker made room
+      OVERRUN_OLDEST,   // Replace the oldest message in the queue
+      DISCARD           // Drop the new message
+   };
+
+   // Where log records take their timestamp from
+   enum class LogClockSource
+   {
+      SYSTEM,   // The system clock, read by every log call
+      TSC       // The invariant time stamp counter, converted to wall time by the backend
+   };
+
+   // Which sinks share a worker behind the async queue
+   enum class LogSinkWorkers
+   {
+      SHARED,      // All sinks write on the queue worker
+      PER_CLASS,   // Console, file and network sinks each get a worker
+      PER_SINK     // Every sink gets a worker
+   };
+
+   struct LogQueueConfig
+   {
+      // Messages waiting for the logging worker. The queue is shared by all levels.
+      size_t queueSize{1024u};
+
+      // Messages are only written in order with a single worker
+      size_t threadCount{1u};
+
+      // Every level waits for room by default. The levels share one queue, so
+      // OVERRUN_OLDEST evicts the oldest queued message whatever its level, also a
+      // warning or error queued before. DISCARD only ever drops the new message.
+      LogOverflowPolicy traceOverflow{LogOverflowPolicy::BLOCK};
+      LogOverflowPolicy infoOverflow{LogOverflowPolicy::BLOCK};
+      LogOverflowPolicy warningOverflow{LogOverflowPolicy::BLOCK};
+      LogOverflowPolicy errorOverflow{LogOverflowPolicy::BLOCK};
+      LogOverflowPolicy criticalOverflow{LogOverflowPolicy::BLOCK};
+
+      // With their own workers a slow sink only delays itself, until it is this many
+      // messages behind the fastest one. Then the queue worker waits for it.
+      LogSinkWorkers sinkWorkers{LogSinkWorkers::SHARED};
+      size_t sinkQueueSize{4096u};
+   };
+
+   struct LogQueueStats
+   {
+      size_t queueSize{0};
+      size_t queueDepth{0};
+
+      // Deepest the queue was seen. Sampled, so short peaks can be missed.
+      size_t highWaterMark{0};
+
+      uint64_t overrun{0};
+      // Also counts deferred messages dropped because the ring of their thread was full
+      uint64_t discarded{0};
+
+      // Time log calls spent waiting for room in the queue
+      std::chrono::nanoseconds blockedTime{0};
+   };
+
+   // When the sinks are flushed. Flushing every line costs a write call per message.
+   struct LogFlushPolicy
+   {
+      // Messages at or above this level are flushed as soon as they are written
+      LogType flushLevel{LogType::WARN};
+
+      // Pending messages are flushed this often. Zero disables the timer.
+      std::chrono::milliseconds interval{1000};
+
+      // Sinks are flushed once this many bytes were written since the last flush
+      size_t maxPendingBytes{64u * 1024u};
+   };
+
+   // Drops repeats of a log call site once it used up its burst within the window.
+   // How many messages were dropped is logged once the window ended, on the next tick
+   // of the flush timer or when the call site logs again. Call sites sharing a slot
+   // report the dropped messages of the one they replace.
+   struct LogSuppressionConfig
+   {
+      // Messages logged per call site and window. Zero disables suppression.
+      uint32_t burst{0u};
+
+      std::chrono::milliseconds window{60000};
+   };
+
+   // Which calls of a sampled call site are logged, see LogSampler
+   struct LogSampling
+   {
+      enum class Mode : uint8_t
+      {
+         EVERY_NTH,     // The first call and every Nth after it
+         PROBABILITY,   // Each call with the given probability
+         PER_SECOND     // At most this many calls per second
+      };
+
+      Mode mode{Mode::EVERY_NTH};
+      uint32_t every{1u};
+      double probability{1.0};
+      uint32_t perSecond{0u};
+
+      static constexpr LogSampling EveryNth(uint32_t n)
+      {
+         return {.mode = Mode::EVERY_NTH, .every = n > 0u ? n : 1u};
+      }
+
+      static constexpr LogSampling Probability(double p)
+      {
+         return {.mode = Mode::PROBABILITY, .probability = p};
+      }
+
+      static constexpr LogSampling PerSecond(uint32_t max)
+      {
+         return {.mode = Mode::PER_SECOND, .perSecond = max};
+      }
+   };
+
+   struct FileLoggingConfig
+   {
+      // Size a log file is rotated at. Each file is preallocated to this size.
+      size_t maxFileSize{5u * 1024u * 1024u};
+
+      // Rotated files kept next to the active one
+      size_t maxFiles{5u};
+
+      // Minimum time between two syncs of the mapped file to disk
+      std::chrono::milliseconds syncInterval{1000};
+
+      // Rotated files are gzip compressed in the background, log.1.txt.gz and so on.
+      // maxFiles then counts compressed files.
+      bool compressRotated{false};
+
+      // zlib level from 1, fastest, to 9, smallest
+      int compressionLevel{6};
+
+      // Text logs keep a log.txt.idx next to each file so QueryFileLog can seek by time and level
+      bool timeIndex{true};
+   };
+
+   // Records of a text log to return. Times are compared to the second, the resolution
+   // of the text log. Unset bounds are open.
+   struct LogQuery
+   {
+      std::optional<std::chrono::system_clock::time_point> from;
+      std::optional<std::chrono::system_clock::time_point> to;
+      LogType minLevel{LogType::TRACE};
+
+      // Only the oldest records up to this count are returned. 0 returns all of them.
+      size_t limit{0};
+   };
+
+   struct LogRecord
+   {
+      std::chrono::system_clock::time_point time;
+      LogType level{LogType::INFO};
+
+      // Message without the time and level. Lines of a multi line message are joined with \n.
+      std::string message;
+   };
+
+   // Limits applied by the worker that sends notifications for a sink
+   struct NotificationLimits
+   {
+      // Messages waiting to be sent. Messages logged while the queue is full are dropped.
+      size_t queueSize{256u};
+
+      // Messages logged within this window of the first one are sent as one digest
+      std::chrono::milliseconds coalesceWindow{2000};
+
+      // Minimum time between two notifications sent by the sink
+      std::chrono::milliseconds minInterval{10000};
+
+      // Messages listed in a digest before the rest are only counted
+      size_t maxDigestLines{20u};
+   };
+
+   struct NotificationStats
+   {
+      std::string name;
+      uint64_t sent{0};
+      uint64_t coalesced{0};
+      uint64_t dropped{0};
+   };
+
    struct AppriseLoggingConfig
    {
       std::string url;
       std::string key;
       std::string message_title;
+      NotificationLimits limits;
    };
 
    struct GotifyLoggingConfig
@@ -53,5 +367,74 @@ namespace warp
       std::string key;
       std::string message_title;
       int32_t priority{0};
+      NotificationLimits limits;
+   };
+
+   enum class LogDatagramFormat
+   {
+      BINARY,   // Records of binary-log-format.h, each datagram a complete stream
+      JSON      // JSON lines like InitJsonLogging writes
+   };
+
+   // Sends records to a local collector over a Unix datagram socket
+   struct DatagramLoggingConfig
+   {
+      // Socket the collector is bound to
+      std::filesystem::path socketPath;
+
+      LogDatagramFormat format{LogDatagramFormat::JSON};
+
+      // Records of a batch are packed into datagrams up to this size. macOS limits
+      // datagrams to net.local.dgram.maxdgram, 2 KB by default.
+      size_t maxDatagramSize{16u * 1024u};
+   };
+
+   struct DatagramStats
+   {
+      std::string socketPath;
+      uint64_t datagrams{0};
+      uint64_t records{0};
+
+      // Records lost because the collector was not there or its socket buffer was full
+      uint64_t dropped{0};
+   };
+
+   // A log file in path/filename
+   struct LogFileOutput
+   {
+      std::filesystem::path path;
+      std::string filename;
+      FileLoggingConfig config;
+   };
+
+   // Everything the logger sets up before it writes. Passed to log::Configure before the
+   // first log call the logging threads start once, with these settings.
+   struct LogConfig
+   {
+      // Unset keeps trace in debug builds or with WARP_LOG_TRACE, info otherwise
+      std::optional<LogType> level;
+
+      LogQueueConfig queue;
+      LogFlushPolicy flush;
+
+      // Name of the logging threads. Workers are numbered when there is more than one.
+      // Linux keeps the first 15 characters of a thread name.
+      std::string threadName{"warp-log"};
+
+      // CPUs the logging threads may run on. Empty leaves them to the scheduler.
+      std::vector<uint32_t> cpuAffinity;
+
+      // Falls back to the system clock on CPUs without an invariant TSC. Only records
+      // captured with deferred formatting or for the backtrace take TSC stamps, other
+      // messages are stamped with the system clock when they are queued.
+      LogClockSource clock{LogClockSource::SYSTEM};
+
+      bool console{true};
+      std::optional<LogFileOutput> textFile;
+      std::optional<LogFileOutput> binaryFile;
+      std::optional<LogFileOutput> jsonFile;
+      std::optional<AppriseLoggingConfig> apprise;
+      std::optional<GotifyLoggingConfig> gotify;
+      std::optional<DatagramLoggingConfig> datagram;
    };
 }
\ No newline at end of file
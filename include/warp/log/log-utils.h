@@ -3,9 +3,11 @@
 #include "warp/log/log-types.h"
 #include "warp/types.h"
 
+#include <algorithm>
 #include <concepts>
 #include <format>
 #include <string>
+#include <string_view>
 #include <type_traits>
 
 template <typename T>
@@ -13,32 +15,89 @@ concept arithmetic = std::is_arithmetic_v<T>;
 
 namespace warp
 {
+   template <typename T>
+   consteval LogFieldType GetFieldType()
+   {
+      if constexpr (std::same_as<T, bool>) return LogFieldType::BOOL;
+      else if constexpr (std::same_as<T, char>) return LogFieldType::STRING;
+      else if constexpr (std::is_floating_point_v<T>) return LogFieldType::FLOAT;
+      else if constexpr (std::is_integral_v<T> && std::is_signed_v<T>) return LogFieldType::INT;
+      else if constexpr (std::is_integral_v<T>) return LogFieldType::UINT;
+      else return LogFieldType::STRING;
+   }
+
+   // Typed field written straight into the output of std::format, see Tag. Strings
+   // and arithmetic values are held by value, anything else by reference, so a
+   // LogTag must not outlive the call it is passed to.
+   template <typename T>
+   struct LogTag
+   {
+      std::string_view name;
+      T value;
+   };
+
+   template <typename T>
+   using LogTagValue = std::conditional_t<std::is_convertible_v<const T&, std::string_view>,
+                                          std::string_view,
+                                          std::conditional_t<std::is_arithmetic_v<T>, T, const T&>>;
+
+   // Returns the value as a typed field without allocating. A format spec on the
+   // placeholder applies to the value: LogWarning("{:.1f}", Tag("progress", 97.53))
+   template <typename T>
+   constexpr LogTag<LogTagValue<T>> Tag(std::string_view name, const T& value)
+   {
+      return {name, value};
+   }
+
+   // Text in a log style written straight into the output of std::format
+   struct LogStyledText
+   {
+      std::string_view text;
+      LogStyle style;
+   };
+
+   constexpr LogStyledText Styled(std::string_view text, LogStyle style)
+   {
+      return {text, style};
+   }
+
+   constexpr LogStyledText Standout(std::string_view text)
+   {
+      return {text, LogStyle::STANDOUT};
+   }
+
+   // Returns the value as a typed field, rendered as tag[value] on the console.
+   // Prefer Tag when the field goes straight into a log call.
    template <typename T>
    inline std::string GetTag(std::string_view tag, const T& value)
    {
-      // std::format will handle converting the value to a string 
-      // regardless of whether it is a string, int, or bool.
-      return std::format("{}{}{}[{}]", ANSI_CODE_TAG, tag, ANSI_CODE_LOG, value);
+      return std::format("{}", Tag(tag, value));
    }
 
    template <arithmetic T>
    inline std::string GetTag(std::string_view tag, const T& value, std::string_view fmt)
    {
-      // Construct the dynamic format string: e.g., "{}{}{}[{:.2f}]"
-      std::string dynamic_fmt = std::format("{}{}{}[{{:{}}}]",
-                                            ANSI_CODE_TAG, tag, ANSI_CODE_LOG, fmt);
+      // Construct the dynamic format string: e.g., "{}{}{}{:.2f}{}"
+      std::string dynamic_fmt = std::format("{}{}{}{{:{}}}{}",
+                                            FIELD_CODE_START<GetFieldType<T>()>, tag, FIELD_CODE_VALUE, fmt, FIELD_CODE_END);
 
       return std::vformat(dynamic_fmt, std::make_format_args(value));
    }
 
    inline std::string GetAnsiText(std::string_view text, std::string_view ansiCode)
    {
-      return std::format("{}{}{}", ansiCode, text, ANSI_CODE_LOG);
+      return std::format("{}{}{}", ansiCode, text, STYLE_CODE_LOG);
+   }
+
+   // Prefer Styled when the text goes straight into a log call
+   inline std::string GetStyledText(std::string_view text, LogStyle style)
+   {
+      return std::format("{}{}{}", GetStyleCode(style), text, STYLE_CODE_LOG);
    }
 
    inline std::string GetStandoutText(std::string_view text)
    {
-      return std::format("{}{}{}", ANSI_CODE_STANDOUT, text, ANSI_CODE_LOG);
+      return GetStyledText(text, LogStyle::STANDOUT);
    }
 
    inline std::string_view GetFormattedPlex()
@@ -63,7 +122,7 @@ namespace warp
 
    inline std::string GetServiceHeader(std::string_view ansiiCode, std::string_view name)
    {
-      return std::format("{}{}{}", ansiiCode, name, ANSI_CODE_LOG);
+      return std::format("{}{}{}", ansiiCode, name, STYLE_CODE_LOG);
    }
 
    inline std::string_view GetFormattedApiName(ApiType type)
@@ -82,4 +141,39 @@ namespace warp
             return ANSI_FORMATTED_UNKNOWN;
       }
    }
-}
\ No newline at end of file
+}
+
+template <typename T>
+struct std::formatter<warp::LogTag<T>, char> : std::formatter<std::remove_cvref_t<T>, char>
+{
+   using Value = std::remove_cvref_t<T>;
+
+   // The spec is parsed by the formatter of the value at compile time
+   template <typename FormatContext>
+   auto format(const warp::LogTag<T>& tag, FormatContext& ctx) const
+   {
+      constexpr auto start = warp::FIELD_CODE_START<warp::GetFieldType<Value>()>;
+
+      auto out = std::copy(start.begin(), start.end(), ctx.out());
+      out = std::copy(tag.name.begin(), tag.name.end(), out);
+      out = std::copy(warp::FIELD_CODE_VALUE.begin(), warp::FIELD_CODE_VALUE.end(), out);
+      ctx.advance_to(out);
+      out = std::formatter<Value, char>::format(tag.value, ctx);
+      return std::copy(warp::FIELD_CODE_END.begin(), warp::FIELD_CODE_END.end(), out);
+   }
+};
+
+template <>
+struct std::formatter<warp::LogStyledText, char> : std::formatter<std::string_view, char>
+{
+   template <typename FormatContext>
+   auto format(const warp::LogStyledText& styled, FormatContext& ctx) const
+   {
+      const auto code = warp::GetStyleCode(styled.style);
+
+      auto out = std::copy(code.begin(), code.end(), ctx.out());
+      ctx.advance_to(out);
+      out = std::formatter<std::string_view, char>::format(styled.text, ctx);
+      return std::copy(warp::STYLE_CODE_LOG.begin(), warp::STYLE_CODE_LOG.end(), out);
+   }
+};
\ No newline at end of file
@@ -2,15 +2,77 @@
 
 #include "warp/log/logger.h"
 
+#include <chrono>
 #include <filesystem>
+#include <optional>
 #include <string_view>
+#include <vector>
+
+// Log macros that remove the call when the level is below WARP_LOG_ACTIVE_LEVEL.
+// Otherwise the arguments are only evaluated once the runtime level check passes.
+#define WARP_LOG_IF_ENABLED(level, enabled, call) \
+   do \
+   { \
+      if constexpr (::warp::IsLogLevelActive(level)) \
+      { \
+         if (enabled) \
+         { \
+            call; \
+         } \
+      } \
+   } while (false)
+
+#define WARP_LOG_IF_ACTIVE(level, call) WARP_LOG_IF_ENABLED(level, ::warp::Logger::WantsMessage(level), call)
+
+// Logs a subset of the calls of this call site, picked by the ::warp::LogSampling.
+// Each expansion keeps its own LogSampler. Skipped calls do not evaluate the arguments.
+#define WARP_LOG_SAMPLED(level, sampling, ...) \
+   do \
+   { \
+      if constexpr (::warp::IsLogLevelActive(level)) \
+      { \
+         if (::warp::Logger::IsEnabled(level)) \
+         { \
+            static ::warp::LogSampler warpLogSampler{sampling}; \
+            ::warp::Logger::Instance().LogSampled(level, warpLogSampler, __VA_ARGS__); \
+         } \
+      } \
+   } while (false)
+
+#define WARP_LOG_TRACE_SAMPLED(sampling, ...) WARP_LOG_SAMPLED(::warp::LogType::TRACE, sampling, __VA_ARGS__)
+
+#define WARP_LOG_TRACE(...) WARP_LOG_IF_ACTIVE(::warp::LogType::TRACE, ::warp::log::Trace(__VA_ARGS__))
+#define WARP_LOG_INFO(...) WARP_LOG_IF_ACTIVE(::warp::LogType::INFO, ::warp::log::Info(__VA_ARGS__))
+#define WARP_LOG_WARNING(...) WARP_LOG_IF_ACTIVE(::warp::LogType::WARN, ::warp::log::Warning(__VA_ARGS__))
+#define WARP_LOG_ERROR(...) WARP_LOG_IF_ACTIVE(::warp::LogType::ERR, ::warp::log::Error(__VA_ARGS__))
+#define WARP_LOG_CRITICAL(...) WARP_LOG_IF_ACTIVE(::warp::LogType::CRITICAL, ::warp::log::Critical(__VA_ARGS__))
 
 namespace warp::log
 {
+   // Sets up the sinks, queue and logging threads. Call before the first log call.
+   inline void Configure(const LogConfig& config)
+   {
+      Logger::Configure(config);
+   }
+
    // Init file logging
-   inline void InitFileLogging(const std::filesystem::path& path, std::string_view filename)
+   inline void InitFileLogging(const std::filesystem::path& path, std::string_view filename, const FileLoggingConfig& config = {})
    {
-      Logger::Instance().InitFileLogging(path, filename);
+      Logger::Instance().InitFileLogging(path, filename, config);
+   }
+
+   // Init binary file logging. Read the files with the warp-log-decode tool. Calls
+   // with raw capturable arguments are stored as call site and arguments, see
+   // Logger::InitBinaryFileLogging.
+   inline void InitBinaryFileLogging(const std::filesystem::path& path, std::string_view filename, const FileLoggingConfig& config = {})
+   {
+      Logger::Instance().InitBinaryFileLogging(path, filename, config);
+   }
+
+   // Init JSON lines logging for log ingestion
+   inline void InitJsonLogging(const std::filesystem::path& path, std::string_view filename, const FileLoggingConfig& config = {})
+   {
+      Logger::Instance().InitJsonLogging(path, filename, config);
    }
 
    // Init Apprise logging
@@ -25,6 +87,97 @@ namespace warp::log
       Logger::Instance().InitGotify(config);
    }
 
+   // Init shipping records to a local collector over a Unix datagram socket
+   inline void InitDatagramLogging(const DatagramLoggingConfig& config)
+   {
+      Logger::Instance().InitDatagramLogging(config);
+   }
+
+   // Sets the lowest level that is logged
+   inline void SetLevel(LogType level)
+   {
+      Logger::Instance().SetLevel(level);
+   }
+
+   // Sets the level of one component, for example "PlexApi(serverA)". Without a level it follows SetLevel again.
+   inline void SetComponentLevel(std::string_view component, std::optional<LogType> level)
+   {
+      Logger::Instance().SetComponentLevel(component, level);
+   }
+
+   // Sets component levels from a list like "PlexApi(serverA)=trace,EmbyApi(x)=default"
+   inline bool SetComponentLevels(std::string_view levels)
+   {
+      return Logger::Instance().SetComponentLevels(levels);
+   }
+
+   // Moves message formatting from the calling thread to the logging backend
+   inline void SetDeferredFormatting(bool enabled)
+   {
+      Logger::Instance().SetDeferredFormatting(enabled);
+   }
+
+   // Sets the async queue size, worker count and what each level does when the queue is full
+   inline void ConfigureQueue(const LogQueueConfig& config)
+   {
+      Logger::Instance().ConfigureQueue(config);
+   }
+
+   // Returns the queue depth, overflow counters and time spent blocked on a full queue
+   inline LogQueueStats GetQueueStats()
+   {
+      return Logger::Instance().GetQueueStats();
+   }
+
+   // Sets when the sinks are flushed: on a timer, after a number of bytes or right away for a level
+   inline void SetFlushPolicy(const LogFlushPolicy& policy)
+   {
+      Logger::Instance().SetFlushPolicy(policy);
+   }
+
+   // Limits how often a single log call is written within a window
+   inline void SetSuppression(const LogSuppressionConfig& config)
+   {
+      Logger::Instance().SetSuppression(config);
+   }
+
+   // Writes out every pending message within the timeout. Call before the application exits.
+   inline void Shutdown(std::chrono::milliseconds timeout = Logger::DEFAULT_SHUTDOWN_TIMEOUT)
+   {
+      Logger::Instance().Shutdown(timeout);
+   }
+
+   // Keeps recent messages below the log level per thread and writes them out before an error
+   inline void SetBacktrace(size_t bytesPerThread)
+   {
+      Logger::Instance().SetBacktrace(bytesPerThread);
+   }
+
+   // Writes out the backtrace of the calling thread
+   inline void DumpBacktrace()
+   {
+      Logger::Instance().DumpBacktrace();
+   }
+
+   // Returns how many notifications were sent, coalesced or dropped per sink
+   inline std::vector<NotificationStats> GetNotificationStats()
+   {
+      return Logger::Instance().GetNotificationStats();
+   }
+
+   // Returns how many records each datagram sink sent and dropped
+   inline std::vector<DatagramStats> GetDatagramStats()
+   {
+      return Logger::Instance().GetDatagramStats();
+   }
+
+   // Returns the records of a text log in a time range and at a minimum level, oldest first.
+   // The time index of each file lets the query seek instead of reading every file.
+   inline std::vector<LogRecord> QueryFileLog(const std::filesystem::path& path, std::string_view filename, const LogQuery& query = {})
+   {
+      return Logger::Instance().QueryFileLog(path, filename, query);
+   }
+
    template<typename... Args>
    inline void Trace(std::format_string<Args...> fmt, Args &&...args)
    {
@@ -1,14 +1,40 @@
 #pragma once
 
+#include "warp/log/log-deferred.h"
+#include "warp/log/log-sampler.h"
 #include "warp/log/log-types.h"
+#include "warp/log/log-utils.h"
 
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
 #include <filesystem>
 #include <format>
+#include <iterator>
 #include <memory>
+#include <optional>
+#include <string>
 #include <string_view>
+#include <vector>
 
 namespace warp
 {
+   namespace detail
+   {
+      // Appends "header: message" to the output in a single formatting pass
+      template<typename... Args>
+      inline void FormatLogMessage(std::string& out, const std::string_view* header, std::format_string<Args...> fmt, Args &&...args)
+      {
+         if (header != nullptr)
+         {
+            out.append(*header);
+            out.append(": ");
+         }
+         std::format_to(std::back_inserter(out), fmt, std::forward<Args>(args)...);
+      }
+   }
+
    class Logger
    {
    public:
@@ -19,9 +45,126 @@ namespace warp
          return instance;
       }
 
-      void InitFileLogging(const std::filesystem::path& path, std::string_view filename);
+      // Sets up the sinks, queue and logging threads. Called before the first use of
+      // the logger the threads are started once, with these settings. Safe against a
+      // first log call on another thread. Later calls replace the queue, its workers
+      // and the sinks and log a warning. Ignored after Shutdown.
+      static void Configure(const LogConfig& config);
+
+      void InitFileLogging(const std::filesystem::path& path, std::string_view filename, const FileLoggingConfig& config = {});
+      // Writes a compact binary record stream instead of text, decode it with warp-log-decode.
+      // Calls whose arguments can be captured raw, see DeferrableArg, are stored as their
+      // call site and arguments, with or without deferred formatting. Those messages are
+      // then formatted for the other sinks on the logging worker. Other calls are
+      // stored as text. Rotation follows the config, the mapped file sync interval does not apply.
+      void InitBinaryFileLogging(const std::filesystem::path& path, std::string_view filename, const FileLoggingConfig& config = {});
+      // Writes one JSON object per message with the GetTag fields as typed values
+      void InitJsonLogging(const std::filesystem::path& path, std::string_view filename, const FileLoggingConfig& config = {});
       void InitApprise(const AppriseLoggingConfig& config);
       void InitGotify(const GotifyLoggingConfig& config);
+      // Sends records to a local collector over a Unix datagram socket
+      void InitDatagramLogging(const DatagramLoggingConfig& config);
+
+      // Sets the lowest level that is logged
+      void SetLevel(LogType level);
+
+      // Returns if a message at the level is logged. Costs a single relaxed load
+      // so it can guard argument evaluation on hot paths.
+      static bool IsEnabled(LogType level)
+      {
+         return level >= activeLevel_.load(std::memory_order_relaxed);
+      }
+
+      // Returns if a log call at the level does anything, either writing the
+      // message or recording it for the backtrace
+      static bool WantsMessage(LogType level)
+      {
+         return IsEnabled(level) || backtrace_.load(std::memory_order_relaxed);
+      }
+
+      static bool IsBacktraceEnabled()
+      {
+         return backtrace_.load(std::memory_order_relaxed);
+      }
+
+      // Level of a component such as a Base object. Follows the global level unless set.
+      using ComponentLevel = std::atomic<int8_t>;
+      static constexpr int8_t COMPONENT_LEVEL_GLOBAL{-1};
+
+      static bool IsEnabled(LogType level, const ComponentLevel& component)
+      {
+         const auto componentLevel = component.load(std::memory_order_relaxed);
+         return componentLevel == COMPONENT_LEVEL_GLOBAL
+            ? IsEnabled(level)
+            : level >= static_cast<LogType>(componentLevel);
+      }
+
+      // Returns the level of the component, creating it on first use. It lives as long as the logger.
+      const ComponentLevel& RegisterComponent(std::string_view name);
+
+      // Sets the level of a component. Without a level it follows the global level again.
+      void SetComponentLevel(std::string_view name, std::optional<LogType> level);
+
+      // Applies a list like "PlexApi(serverA)=trace,EmbyApi(x)=default", also read from
+      // WARP_LOG_LEVELS at start up. Returns false if an entry was not understood.
+      bool SetComponentLevels(std::string_view levels);
+
+      // When enabled log calls with simple arguments only copy the raw argument bytes
+      // into a per thread ring and the message is formatted on the logging backend
+      void SetDeferredFormatting(bool enabled);
+
+      // Keeps the most recent messages below the log level in a ring of this many
+      // bytes per thread, captured unformatted. The ring of a thread is written out
+      // before an error on that thread or by DumpBacktrace. Zero disables it.
+      void SetBacktrace(size_t bytesPerThread);
+
+      // Writes out the backtrace of the calling thread
+      void DumpBacktrace();
+
+      // Replaces the async queue and its workers. Messages already queued are
+      // written first. Meant to be called during start up, ignored after Shutdown.
+      void ConfigureQueue(const LogQueueConfig& config);
+
+      [[nodiscard]] LogQueueStats GetQueueStats() const;
+
+      void SetFlushPolicy(const LogFlushPolicy& policy);
+
+      // Limits how often a call site is logged, also for the notification sinks
+      void SetSuppression(const LogSuppressionConfig& config);
+
+      static constexpr std::chrono::milliseconds DEFAULT_SHUTDOWN_TIMEOUT{5000};
+
+      // Writes everything captured or queued, flushes every sink and stops the
+      // notification workers, giving up after the timeout. A worker still busy then,
+      // for example sending to an unreachable endpoint, is left behind so the
+      // application can exit. Messages logged afterwards are written synchronously
+      // on the calling thread, no longer flushed on a timer or sent as notifications.
+      // Later calls do nothing.
+      void Shutdown(std::chrono::milliseconds timeout = DEFAULT_SHUTDOWN_TIMEOUT);
+
+      // Returns the delivery counters of the notification sinks
+      [[nodiscard]] std::vector<NotificationStats> GetNotificationStats() const;
+      [[nodiscard]] std::vector<DatagramStats> GetDatagramStats() const;
+
+      // Returns the records of a text log set up with InitFileLogging and its rotated files
+      std::vector<LogRecord> QueryFileLog(const std::filesystem::path& path, std::string_view filename, const LogQuery& query);
+
+      // Logs without the global level check, for callers that checked their own level
+      template<typename... Args>
+      void LogWithHeader(LogType level, std::string_view header, std::format_string<Args...> fmt, Args &&...args);
+
+      // Logs the message if the sampler picks this call. The count of calls skipped
+      // before it is added as a skipped tag. See WARP_LOG_TRACE_SAMPLED.
+      template<typename... Args>
+      void LogSampled(LogType level, LogSampler& sampler, std::format_string<Args...> fmt, Args &&...args);
+
+      // Same as LogSampled for callers that checked their own level
+      template<typename... Args>
+      void LogSampledWithHeader(LogType level, std::string_view header, LogSampler& sampler, std::format_string<Args...> fmt, Args &&...args);
+
+      // Records the message in the backtrace of the calling thread, for callers that checked their own level
+      template<typename... Args>
+      void CaptureWithHeader(LogType level, std::string_view header, std::format_string<Args...> fmt, Args &&...args);
 
       template<typename... Args>
       void Trace(std::format_string<Args...> fmt, Args &&...args);
@@ -57,104 +200,395 @@ namespace warp
       Logger();
       virtual ~Logger();
 
+      void Apply(const LogConfig& config);
+
+      // Starts the queue of the config and takes over its overflow policies
+      void StartQueue(const LogQueueConfig& config);
+
       void LogInternal(LogType level, std::string_view msg);
-      bool ShouldLog(LogType level);
+
+      // Logs the message if the level is enabled, otherwise records it for the backtrace
+      template<typename... Args>
+      void Route(LogType level, const std::string_view* header, std::format_string<Args...> fmt, Args &&...args);
+
+      template<typename... Args>
+      void Sampled(LogType level, const std::string_view* header, LogSampler& sampler, std::format_string<Args...> fmt, Args &&...args);
+
+      template<typename... Args>
+      void Capture(LogType level, const std::string_view* header, std::format_string<Args...> fmt, Args &&...args);
+
+      template<typename... Args>
+      void WriteBacktraceRecord(DeferredRing& ring, LogType level, const std::string_view* header, std::string_view fmt, const Args &...args);
+
+      // Returns the backtrace ring of the calling thread or nullptr if the backtrace is disabled
+      DeferredRing* GetBacktraceRing();
+
+      template<typename... Args>
+      void Dispatch(LogType level, const std::string_view* header, std::format_string<Args...> fmt, Args &&...args);
+
+      // Applies suppression and writes out the backtrace before an error. Returns false if the call is suppressed.
+      bool Admit(LogType level, const std::string_view* header, std::string_view fmt);
+
+      // Writes the message deferred if possible, otherwise formats it
+      template<typename... Args>
+      void Emit(LogType level, const std::string_view* header, std::format_string<Args...> fmt, Args &&...args);
+
+      // Calls the function with the format buffer of the calling thread, cleared.
+      // The message is copied into the queue before the buffer is reused.
+      template<typename Func>
+      static void WithFormatBuffer(Func&& func);
+
+      template<typename... Args>
+      bool LogDeferred(LogType level, const std::string_view* header, std::string_view fmt, const Args &...args);
+
+      DeferredRing& GetThreadRing();
+      bool WaitForDeferredSpace();
+      void FlushDeferred();
+
+      // Captures the call into a record and queues it for the sinks storing records
+      template<typename... Args>
+      bool QueueRecord(LogType level, const std::string_view* header, std::string_view fmt, const Args &...args);
+
+      // Returns the scratch ring of the calling thread for QueueRecord
+      DeferredRing& GetRecordRing();
+
+      // Queues the records of the scratch ring and releases them
+      void WriteRecordRing(DeferredRing& ring);
+
+      // Returns false if the call site used up its burst in the current window
+      bool PassSuppression(LogType level, const std::string_view* header, std::string_view fmt);
 
       struct Impl;
       std::unique_ptr<Impl> pimpl_;
+
+      std::atomic_bool deferred_{false};
+      std::atomic_bool suppress_{false};
+
+      // Set while a sink stores records, see InitBinaryFileLogging
+      std::atomic_bool records_{false};
+
+      // Overflow policy of each level, also applied when a deferred ring is full
+      std::array<std::atomic<LogOverflowPolicy>, static_cast<size_t>(LogType::CRITICAL) + 1u> overflow_{};
+      std::atomic<uint64_t> deferredDiscarded_{0};
+
+      // Starts at the default level of the build and WARP_LOG_TRACE
+      static std::atomic<LogType> activeLevel_;
+      static inline std::atomic_bool backtrace_{false};
+
+      // Buffers above this size are released after use instead of kept for the thread
+      static constexpr size_t MAX_FORMAT_BUFFER_SIZE{64u * 1024u};
+
+      struct FormatBuffer
+      {
+         std::string text;
+         bool inUse{false};
+      };
+      static thread_local FormatBuffer formatBuffer_;
    };
 
+   inline thread_local Logger::FormatBuffer Logger::formatBuffer_;
+
+   template<typename Func>
+   inline void Logger::WithFormatBuffer(Func&& func)
+   {
+      auto& buffer = formatBuffer_;
+
+      // A formatter that logs while its own message is being formatted gets a buffer of its own
+      if (buffer.inUse)
+      {
+         std::string text;
+         func(text);
+         return;
+      }
+
+      struct Release
+      {
+         FormatBuffer& buffer;
+         ~Release()
+         {
+            buffer.inUse = false;
+            if (buffer.text.capacity() > MAX_FORMAT_BUFFER_SIZE) buffer.text = std::string();
+         }
+      };
+
+      buffer.inUse = true;
+      Release release{buffer};
+      buffer.text.clear();
+      func(buffer.text);
+   }
+
+   template<typename... Args>
+   inline void Logger::Route(LogType level, const std::string_view* header, std::format_string<Args...> fmt, Args &&...args)
+   {
+      if (IsEnabled(level))
+      {
+         Dispatch(level, header, fmt, std::forward<Args>(args)...);
+      }
+      else if (backtrace_.load(std::memory_order_relaxed))
+      {
+         Capture(level, header, fmt, std::forward<Args>(args)...);
+      }
+   }
+
+   template<typename... Args>
+   inline void Logger::Sampled(LogType level, const std::string_view* header, LogSampler& sampler, std::format_string<Args...> fmt, Args &&...args)
+   {
+      if (!sampler.Sample() || !Admit(level, header, fmt.get())) return;
+
+      const auto skipped = sampler.TakeSkipped();
+      if (skipped == 0u)
+      {
+         Emit(level, header, fmt, std::forward<Args>(args)...);
+         return;
+      }
+
+      // The tag changes the format, the message is formatted with it and passed on as text
+      WithFormatBuffer([&](std::string& msg) {
+         detail::FormatLogMessage(msg, nullptr, fmt, std::forward<Args>(args)...);
+         std::format_to(std::back_inserter(msg), " {}", Tag("skipped", skipped));
+         Emit(level, header, "{}", std::string_view(msg));
+      });
+   }
+
+   template<typename... Args>
+   inline void Logger::LogSampled(LogType level, LogSampler& sampler, std::format_string<Args...> fmt, Args &&...args)
+   {
+      if (IsEnabled(level))
+      {
+         Sampled(level, nullptr, sampler, fmt, std::forward<Args>(args)...);
+      }
+   }
+
+   template<typename... Args>
+   inline void Logger::LogSampledWithHeader(LogType level, std::string_view header, LogSampler& sampler, std::format_string<Args...> fmt, Args &&...args)
+   {
+      Sampled(level, &header, sampler, fmt, std::forward<Args>(args)...);
+   }
+
+   template<typename... Args>
+   inline void Logger::Capture(LogType level, const std::string_view* header, std::format_string<Args...> fmt, Args &&...args)
+   {
+      auto* ring = GetBacktraceRing();
+      if (ring == nullptr) return;
+
+      if constexpr ((DeferrableArg<Args> && ...))
+      {
+         WriteBacktraceRecord(*ring, level, header, fmt.get(), args...);
+      }
+      else
+      {
+         // Arguments that can not be captured raw are formatted right away
+         WithFormatBuffer([&](std::string& msg) {
+            detail::FormatLogMessage(msg, nullptr, fmt, std::forward<Args>(args)...);
+            WriteBacktraceRecord(*ring, level, header, "{}", std::string_view(msg));
+         });
+      }
+   }
+
+   template<typename... Args>
+   inline void Logger::WriteBacktraceRecord(DeferredRing& ring, LogType level, const std::string_view* header, std::string_view fmt, const Args &...args)
+   {
+      const auto size = detail::DeferredRecordSize(header, args...);
+      if (size > ring.MaxRecordSize() || (header != nullptr && header->size() > UINT16_MAX))
+      {
+         return;
+      }
+
+      // Only the owning thread reads the ring, drop the oldest records until this one fits
+      while (!detail::WriteDeferredRecord(ring, size, level, header, fmt, args...))
+      {
+         const auto* oldest = ring.Peek();
+         if (oldest == nullptr) return;
+         ring.Pop(oldest);
+      }
+   }
+
+   template<typename... Args>
+   inline void Logger::Dispatch(LogType level, const std::string_view* header, std::format_string<Args...> fmt, Args &&...args)
+   {
+      if (Admit(level, header, fmt.get()))
+      {
+         Emit(level, header, fmt, std::forward<Args>(args)...);
+      }
+   }
+
+   inline bool Logger::Admit(LogType level, const std::string_view* header, std::string_view fmt)
+   {
+      if (suppress_.load(std::memory_order_relaxed) && !PassSuppression(level, header, fmt))
+      {
+         return false;
+      }
+
+      // The context leading up to an error goes out first
+      if (level >= LogType::ERR && backtrace_.load(std::memory_order_relaxed))
+      {
+         DumpBacktrace();
+      }
+      return true;
+   }
+
+   template<typename... Args>
+   inline void Logger::Emit(LogType level, const std::string_view* header, std::format_string<Args...> fmt, Args &&...args)
+   {
+      if constexpr ((DeferrableArg<Args> && ...))
+      {
+         if (deferred_.load(std::memory_order_relaxed) && LogDeferred(level, header, fmt.get(), args...))
+         {
+            return;
+         }
+
+         // Sinks that store records get the call site and arguments without deferred formatting too
+         if (records_.load(std::memory_order_relaxed) && QueueRecord(level, header, fmt.get(), args...))
+         {
+            return;
+         }
+      }
+
+      WithFormatBuffer([&](std::string& msg) {
+         detail::FormatLogMessage(msg, header, fmt, std::forward<Args>(args)...);
+         LogInternal(level, msg);
+      });
+   }
+
+   template<typename... Args>
+   inline bool Logger::LogDeferred(LogType level, const std::string_view* header, std::string_view fmt, const Args &...args)
+   {
+      auto& ring = GetThreadRing();
+      const auto size = detail::DeferredRecordSize(header, args...);
+      if (size > ring.MaxRecordSize() || (header != nullptr && header->size() > UINT16_MAX))
+      {
+         return false;
+      }
+
+      while (!detail::WriteDeferredRecord(ring, size, level, header, fmt, args...))
+      {
+         // The backend is behind. Levels that discard drop the message and levels that
+         // overrun leave it to the queue. Blocking levels wait unless the backend stopped.
+         const auto policy = overflow_[static_cast<size_t>(level)].load(std::memory_order_relaxed);
+         if (policy == LogOverflowPolicy::DISCARD)
+         {
+            deferredDiscarded_.fetch_add(1, std::memory_order_relaxed);
+            return true;
+         }
+         if (policy != LogOverflowPolicy::BLOCK || !WaitForDeferredSpace()) return false;
+      }
+
+      // Stopping the backend drains the rings a last time after clearing deferred_.
+      // A record committed too late for that drain is written out here.
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      if (!deferred_.load(std::memory_order_relaxed)) FlushDeferred();
+      return true;
+   }
+
+   template<typename... Args>
+   inline bool Logger::QueueRecord(LogType level, const std::string_view* header, std::string_view fmt, const Args &...args)
+   {
+      auto& ring = GetRecordRing();
+      const auto size = detail::DeferredRecordSize(header, args...);
+      if (size > ring.MaxRecordSize() || (header != nullptr && header->size() > UINT16_MAX))
+      {
+         return false;
+      }
+
+      // The ring only holds the record until it is copied into the queue
+      if (!detail::WriteDeferredRecord(ring, size, level, header, fmt, args...)) return false;
+      WriteRecordRing(ring);
+      return true;
+   }
+
+   template<typename... Args>
+   inline void Logger::LogWithHeader(LogType level, std::string_view header, std::format_string<Args...> fmt, Args &&...args)
+   {
+      Dispatch(level, &header, fmt, std::forward<Args>(args)...);
+   }
+
+   template<typename... Args>
+   inline void Logger::CaptureWithHeader(LogType level, std::string_view header, std::format_string<Args...> fmt, Args &&...args)
+   {
+      Capture(level, &header, fmt, std::forward<Args>(args)...);
+   }
+
    template<typename... Args>
    inline void Logger::Trace(std::format_string<Args...> fmt, Args &&...args)
    {
-      if (ShouldLog(LogType::TRACE))
+      if constexpr (IsLogLevelActive(LogType::TRACE))
       {
-         std::string msg = std::format(fmt, std::forward<Args>(args)...);
-         LogInternal(LogType::TRACE, msg);
+         Route(LogType::TRACE, nullptr, fmt, std::forward<Args>(args)...);
       }
    }
 
    template<typename... Args>
    inline void Logger::TraceWithHeader(std::string_view header, std::format_string<Args...> fmt, Args &&...args)
    {
-      if (ShouldLog(LogType::TRACE))
+      if constexpr (IsLogLevelActive(LogType::TRACE))
       {
-         std::string msg = std::format("{}: {}", header, std::format(fmt, std::forward<Args>(args)...));
-         LogInternal(LogType::TRACE, msg);
+         Route(LogType::TRACE, &header, fmt, std::forward<Args>(args)...);
       }
    }
 
    template<typename... Args>
    inline void Logger::Info(std::format_string<Args...> fmt, Args &&...args)
    {
-      if (ShouldLog(LogType::INFO))
+      if constexpr (IsLogLevelActive(LogType::INFO))
       {
-         std::string msg = std::format(fmt, std::forward<Args>(args)...);
-         LogInternal(LogType::INFO, msg);
+         Route(LogType::INFO, nullptr, fmt, std::forward<Args>(args)...);
       }
    }
 
    template<typename... Args>
    inline void Logger::InfoWithHeader(std::string_view header, std::format_string<Args...> fmt, Args &&...args)
    {
-      if (ShouldLog(LogType::INFO))
+      if constexpr (IsLogLevelActive(LogType::INFO))
       {
-         std::string msg = std::format("{}: {}", header, std::format(fmt, std::forward<Args>(args)...));
-         LogInternal(LogType::INFO, msg);
+         Route(LogType::INFO, &header, fmt, std::forward<Args>(args)...);
       }
    }
 
    template<typename... Args>
    inline void Logger::Warning(std::format_string<Args...> fmt, Args &&...args)
    {
-      if (ShouldLog(LogType::WARN))
+      if constexpr (IsLogLevelActive(LogType::WARN))
       {
-         std::string msg = std::format(fmt, std::forward<Args>(args)...);
-         LogInternal(LogType::WARN, msg);
+         Route(LogType::WARN, nullptr, fmt, std::forward<Args>(args)...);
       }
    }
 
    template<typename... Args>
    inline void Logger::WarningWithHeader(std::string_view header, std::format_string<Args...> fmt, Args &&...args)
    {
-      if (ShouldLog(LogType::WARN))
+      if constexpr (IsLogLevelActive(LogType::WARN))
       {
-         std::string msg = std::format("{}: {}", header, std::format(fmt, std::forward<Args>(args)...));
-         LogInternal(LogType::WARN, msg);
+         Route(LogType::WARN, &header, fmt, std::forward<Args>(args)...);
       }
    }
 
    template<typename... Args>
    inline void Logger::Error(std::format_string<Args...> fmt, Args &&...args)
    {
-      if (ShouldLog(LogType::ERR))
+      if constexpr (IsLogLevelActive(LogType::ERR))
       {
-         std::string msg = std::format(fmt, std::forward<Args>(args)...);
-         LogInternal(LogType::ERR, msg);
+         Route(LogType::ERR, nullptr, fmt, std::forward<Args>(args)...);
       }
    }
 
    template<typename... Args>
    inline void Logger::ErrorWithHeader(std::string_view header, std::format_string<Args...> fmt, Args &&...args)
    {
-      if (ShouldLog(LogType::ERR))
+      if constexpr (IsLogLevelActive(LogType::ERR))
       {
-         std::string msg = std::format("{}: {}", header, std::format(fmt, std::forward<Args>(args)...));
-         LogInternal(LogType::ERR, msg);
+         Route(LogType::ERR, &header, fmt, std::forward<Args>(args)...);
       }
    }
 
    template<typename... Args>
    inline void Logger::Critical(std::format_string<Args...> fmt, Args &&...args)
    {
-      std::string msg = std::format(fmt, std::forward<Args>(args)...);
-      LogInternal(LogType::CRITICAL, msg);
+      Dispatch(LogType::CRITICAL, nullptr, fmt, std::forward<Args>(args)...);
    }
 
    template<typename... Args>
    inline void Logger::CriticalWithHeader(std::string_view header, std::format_string<Args...> fmt, Args &&...args)
    {
-      std::string msg = std::format("{}: {}", header, std::format(fmt, std::forward<Args>(args)...));
-      LogInternal(LogType::CRITICAL, msg);
+      Dispatch(LogType::CRITICAL, &header, fmt, std::forward<Args>(args)...);
    }
 }
\ No newline at end of file
@@ -1,16 +1,25 @@
 #pragma once
 
 #include <algorithm>
+#include <bit>
 #include <cctype>
 #include <chrono>
+#include <cstring>
 #include <cwctype>
 #include <filesystem>
 #include <format>
-#include <regex>
 #include <sstream>
 #include <string>
 #include <string_view>
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define WARP_UTILS_SSE2
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define WARP_UTILS_NEON
+#endif
+
 namespace warp
 {
    inline std::string GetServerName(std::string_view server, std::string_view serverInstance)
@@ -34,11 +43,101 @@ namespace warp
       }
    }
 
+   inline constexpr char ANSII_ESCAPE{'\x1B'};
+
+   // Returns the position of the first of either character at or after pos, scanning
+   // 16 bytes at a time where SIMD is available
+   inline size_t FindFirstOf(std::string_view data, size_t pos, char first, char second)
+   {
+      const auto* ptr = data.data();
+      const auto size = data.size();
+
+#if defined(WARP_UTILS_SSE2)
+      const auto firstMask = _mm_set1_epi8(first);
+      const auto secondMask = _mm_set1_epi8(second);
+      for (; pos + 16 <= size; pos += 16)
+      {
+         auto chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ptr + pos));
+         auto matches = _mm_or_si128(_mm_cmpeq_epi8(chunk, firstMask), _mm_cmpeq_epi8(chunk, secondMask));
+         if (auto mask = static_cast<unsigned>(_mm_movemask_epi8(matches)); mask != 0)
+         {
+            return pos + std::countr_zero(mask);
+         }
+      }
+#elif defined(WARP_UTILS_NEON)
+      const auto firstMask = vdupq_n_u8(static_cast<uint8_t>(first));
+      const auto secondMask = vdupq_n_u8(static_cast<uint8_t>(second));
+      for (; pos + 16 <= size; pos += 16)
+      {
+         auto chunk = vld1q_u8(reinterpret_cast<const uint8_t*>(ptr + pos));
+         auto matches = vorrq_u8(vceqq_u8(chunk, firstMask), vceqq_u8(chunk, secondMask));
+         if (vmaxvq_u8(matches) != 0) break;
+      }
+#endif
+
+      for (; pos < size; ++pos)
+      {
+         if (ptr[pos] == first || ptr[pos] == second) return pos;
+      }
+      return std::string_view::npos;
+   }
+
+   // Returns the length of the ansii escape sequence starting at pos or 0 if there is none.
+   // Matches ESC followed by a single character in @-Z or \-_, or a control sequence:
+   // ESC [ parameter bytes (0-?) intermediate bytes (space-/) and a final byte (@-~).
+   inline size_t GetAnsiiSequenceLength(std::string_view data, size_t pos)
+   {
+      if (pos + 1 >= data.size() || data[pos] != ANSII_ESCAPE) return 0;
+
+      const auto c = data[pos + 1];
+      if (c == '[')
+      {
+         auto i = pos + 2;
+         while (i < data.size() && data[i] >= 0x30 && data[i] <= 0x3F) ++i;
+         while (i < data.size() && data[i] >= 0x20 && data[i] <= 0x2F) ++i;
+         return (i < data.size() && data[i] >= 0x40 && data[i] <= 0x7E) ? i + 1 - pos : 0;
+      }
+
+      return ((c >= '@' && c <= 'Z') || (c >= '\\' && c <= '_')) ? 2 : 0;
+   }
+
+   // Strips ansii codes from data into out, which must hold at least data.size() characters.
+   // Returns the number of characters written.
+   inline size_t StripAnsiiCharacters(std::string_view data, char* out)
+   {
+      size_t written{0};
+      size_t pos{0};
+      while (pos < data.size())
+      {
+         const auto next = FindFirstOf(data, pos, ANSII_ESCAPE, ANSII_ESCAPE);
+         const auto end = next == std::string_view::npos ? data.size() : next;
+
+         std::memcpy(out + written, data.data() + pos, end - pos);
+         written += end - pos;
+         if (next == std::string_view::npos) break;
+
+         if (auto length = GetAnsiiSequenceLength(data, next); length > 0)
+         {
+            pos = next + length;
+         }
+         else
+         {
+            // A lone escape character is kept
+            out[written++] = ANSII_ESCAPE;
+            pos = next + 1;
+         }
+      }
+      return written;
+   }
+
    inline std::string StripAnsiiCharacters(const std::string& data)
    {
-      // Strip ansii codes from the log msg
-      const std::regex ansii(R"(\x1B(?:[@-Z\\-_]|\[[0-?]*[ -/]*[@-~]))");
-      return std::regex_replace(data, ansii, "");
+      // Most messages have no codes left, skip the copy into a scratch buffer
+      if (FindFirstOf(data, 0, ANSII_ESCAPE, ANSII_ESCAPE) == std::string_view::npos) return data;
+
+      std::string result(data.size(), '\0');
+      result.resize(StripAnsiiCharacters(std::string_view(data), result.data()));
+      return result;
    }
 
    template <typename CharT>
@@ -179,7 +179,7 @@ namespace warp
          return true;
       }
 
-      if (log) LogWarning("{} - HTTP error {}", name, warp::GetTag("error", error));
+      if (log) LogWarning("{} - HTTP error {}", name, warp::Tag("error", error));
       return false;
    }
 
@@ -111,7 +111,7 @@ namespace warp
             .url = serverConfig.url,
             .apiKey = serverConfig.apiKey,
             .className = "EmbyApi",
-            .ansiiCode = ANSI_CODE_EMBY,
+            .ansiiCode = STYLE_CODE_EMBY,
             .prettyName = GetServerName(GetFormattedEmby(), serverConfig.serverName)})
       , pimpl_(std::make_unique<EmbyApiImpl>(*this, appName, version, serverConfig))
    {
@@ -264,7 +264,7 @@ namespace warp
          return returnItem;
       }
 
-      LogWarning("{} returned no valid results {}", __func__, GetTag("search", name));
+      LogWarning("{} returned no valid results {}", __func__, Tag("search", name));
       return std::nullopt;
    }
 
@@ -607,7 +607,7 @@ namespace warp
 
    void EmbyApi::EmbyApiImpl::RebuildPathMap()
    {
-      parent_.LogTrace("Rebuilding Path Map");
+      WARP_BASE_LOG_TRACE(parent_, "Rebuilding Path Map");
 
       static const ApiParams apiParams = {
          {RECURSIVE, "true"},
@@ -663,7 +663,7 @@ namespace warp
 
    void EmbyApi::EmbyApiImpl::RebuildLibraryMap()
    {
-      parent_.LogTrace("Rebuilding Library Map");
+      WARP_BASE_LOG_TRACE(parent_, "Rebuilding Library Map");
 
       auto res = parent_.Get(parent_.BuildApiPath(API_MEDIA_FOLDERS), headers_);
       if (!parent_.IsHttpSuccess(__func__, res))
@@ -697,7 +697,7 @@ namespace warp
 
    void EmbyApi::EmbyApiImpl::RebuildUsersMap()
    {
-      parent_.LogTrace("Rebuilding User Map");
+      WARP_BASE_LOG_TRACE(parent_, "Rebuilding User Map");
 
       auto res = parent_.Get(parent_.BuildApiPath(API_USERS), headers_);
       if (!parent_.IsHttpSuccess(__func__, res))
@@ -776,7 +776,7 @@ namespace warp
          if (item.DateCreated > latestUpdateTimestamp)
             latestUpdateTimestamp = item.DateCreated;
 
-         parent_.LogTrace("Incremental update: Path:{} -> Id:{}", item.Path.string(), item.Id);
+         WARP_BASE_LOG_TRACE(parent_, "Incremental update: Path:{} -> Id:{}", item.Path.string(), item.Id);
          pathMap_.insert_or_assign(std::move(item.Path), std::move(item.Id));
       }
 
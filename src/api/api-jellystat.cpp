@@ -44,7 +44,7 @@ namespace warp
             .url = serverConfig.trackerUrl,
             .apiKey = serverConfig.trackerApiKey,
             .className = "JellystatApi",
-            .ansiiCode = ANSI_CODE_JELLYSTAT,
+            .ansiiCode = STYLE_CODE_JELLYSTAT,
             .prettyName = GetServerName(GetFormattedJellystat(), serverConfig.serverName)})
       , pimpl_(std::make_unique<JellystatApiImpl>(*this, appName, version))
    {
@@ -69,15 +69,15 @@ namespace warp
          auto reported = api->GetServerReportedName();
          log::Info("Connected to {}({}) successfully.{}",
                    serverName, api->GetName(),
-                   reported ? std::format(" Server reported {}", GetTag("name", *reported)) : "");
+                   reported ? std::format(" Server reported {}", Tag("name", *reported)) : "");
       }
 
       void LogServerConnectionError(std::string_view serverName, ApiBase* api)
       {
          log::Warning("{}({}) server not available. Is this correct? {} {}",
                       serverName, api->GetName(),
-                      GetTag("url", api->GetUrl()),
-                      GetTag("api_key", api->GetApiKey()));
+                      Tag("url", api->GetUrl()),
+                      Tag("api_key", api->GetApiKey()));
       }
 
       template <typename ApiT, typename ContainerT, typename OptionsT>
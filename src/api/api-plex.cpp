@@ -153,7 +153,7 @@ namespace warp
                 .url = serverConfig.url,
                 .apiKey = serverConfig.apiKey,
                 .className = "PlexApi",
-                .ansiiCode = ANSI_CODE_PLEX,
+                .ansiiCode = STYLE_CODE_PLEX,
                 .prettyName = GetServerName(GetFormattedPlex(), serverConfig.serverName)})
       , pimpl_(std::make_unique<PlexApiImpl>(*this, appName, version, serverConfig))
    {
@@ -276,7 +276,7 @@ namespace warp
              iter == pimpl_->pathToIdCache_.end())
          {
             LogWarning("{} - No rating key found for path {}",
-                       __func__, GetTag("path", filePath.generic_string()));
+                       __func__, Tag("path", filePath.generic_string()));
             return std::nullopt;
          }
          else
@@ -362,7 +362,7 @@ namespace warp
       if (userToken.empty())
       {
          LogWarning("{} - No token found for user {}",
-                   __func__, GetTag("userName", userName));
+                   __func__, Tag("userName", userName));
          return std::nullopt;
       }
 
@@ -516,7 +516,7 @@ namespace warp
          std::chrono::hh_mm_ss timeSplit{std::chrono::duration_cast<std::chrono::seconds>(d)};
          LogError("{} - Failed to mark {} to play location {}:{}:{}",
                   __func__,
-                  GetTag("ratingKey", ratingKey),
+                  Tag("ratingKey", ratingKey),
                   timeSplit.hours().count(),
                   timeSplit.minutes().count(),
                   timeSplit.seconds().count());
@@ -541,7 +541,7 @@ namespace warp
       if (userToken.empty())
       {
          LogWarning("{} - No token found for user {}",
-                    __func__, GetTag("userName", userName));
+                    __func__, Tag("userName", userName));
          return false;
       }
 
@@ -564,7 +564,7 @@ namespace warp
       auto res = Get(apiPath, headersToUse);
       if (!IsHttpSuccess(__func__, res))
       {
-         LogError("{} - Failed to mark {} as watched", __func__, GetTag("ratingKey", ratingKey));
+         LogError("{} - Failed to mark {} as watched", __func__, Tag("ratingKey", ratingKey));
          return false;
       }
 
@@ -586,7 +586,7 @@ namespace warp
       if (userToken.empty())
       {
          LogWarning("{} - No token found for user {}",
-                    __func__, GetTag("userName", userName));
+                    __func__, Tag("userName", userName));
          return false;
       }
 
@@ -595,7 +595,7 @@ namespace warp
 
    void PlexApi::PlexApiImpl::RebuildLibraryMap()
    {
-      parent_.LogTrace("Rebuilding Library Map");
+      WARP_BASE_LOG_TRACE(parent_, "Rebuilding Library Map");
 
       auto res = parent_.Get(parent_.BuildApiPath(API_LIBRARIES), adminHeaders_);
       if (!parent_.IsHttpSuccess(__func__, res))
@@ -634,7 +634,7 @@ namespace warp
 
    void PlexApi::PlexApiImpl::RebuildCollectionMap()
    {
-      parent_.LogTrace("Rebuilding Collection Map");
+      WARP_BASE_LOG_TRACE(parent_, "Rebuilding Collection Map");
 
       std::vector<std::string> libraryIds;
       {
@@ -695,7 +695,7 @@ namespace warp
 
    void PlexApi::PlexApiImpl::RebuildPathMap()
    {
-      parent_.LogTrace("Rebuilding Path Map");
+      WARP_BASE_LOG_TRACE(parent_, "Rebuilding Path Map");
 
       // Returns the type to search for based on the library type.
       // For now ignore libraries that do not use the plex.agents for scanning.
@@ -824,7 +824,7 @@ namespace warp
 
    void PlexApi::PlexApiImpl::RebuildUserTokenMap()
    {
-      parent_.LogTrace("Rebuilding User Token Map");
+      WARP_BASE_LOG_TRACE(parent_, "Rebuilding User Token Map");
 
       auto checkHttpSuccess = [this](const httplib::Result& res, std::string_view function) {
          if (res.error() != httplib::Error::Success
@@ -1031,7 +1031,7 @@ namespace warp
                   if (part.file.empty())
                      continue;
 
-                  parent_.LogTrace("Incremental update: Path:{} -> RatingKey:{}", part.file.string(), item.ratingKey);
+                  WARP_BASE_LOG_TRACE(parent_, "Incremental update: Path:{} -> RatingKey:{}", part.file.string(), item.ratingKey);
                   idToPathCache_.insert_or_assign(item.ratingKey, part.file);
                   pathToIdCache_.insert_or_assign(part.file, item.ratingKey);
 
@@ -78,7 +78,7 @@ namespace warp
             .url = serverConfig.trackerUrl,
             .apiKey = serverConfig.trackerApiKey,
             .className = "TautulliApi",
-            .ansiiCode = ANSI_CODE_TAUTULLI,
+            .ansiiCode = STYLE_CODE_TAUTULLI,
             .prettyName = GetServerName(GetFormattedTautulli(), serverConfig.serverName)})
       , pimpl_(std::make_unique<TautulliApiImpl>(*this, appName, version))
    {
@@ -237,7 +237,7 @@ namespace warp
 
    bool TautulliApi::TautulliApiImpl::RefreshMonitoringData()
    {
-      parent_.LogTrace("Updating Monitoring Data");
+      WARP_BASE_LOG_TRACE(parent_, "Updating Monitoring Data");
 
       auto apiPath = parent_.BuildApiParamsPath("", {
          GetCmdParam(CMD_GET_SETTINGS),
@@ -10,8 +10,11 @@ namespace warp
               std::string_view ansiiCode,
               std::optional<std::string_view> classExtra)
       : header_(classExtra.has_value()
-                ? std::format("{}{}{}({})", ansiiCode, className, warp::ANSI_CODE_LOG, classExtra.value())
+                ? std::format("{}{}{}({})", ansiiCode, className, warp::STYLE_CODE_LOG, classExtra.value())
                 : warp::GetServiceHeader(ansiiCode, className))
+      , componentLevel_(&Logger::Instance().RegisterComponent(classExtra.has_value()
+                                                                  ? std::format("{}({})", className, classExtra.value())
+                                                                  : std::string(className)))
    {
    }
 }
\ No newline at end of file
@@ -1,46 +1,87 @@
 #include "ansii-formatter.h"
 
 #include "internal-types.h"
+#include "timestamp-cache.h"
+
+#include <spdlog/details/os.h>
+
+#include <format>
+#include <string_view>
 
 namespace warp
 {
-   AnsiiFormatter::AnsiiFormatter()
+   namespace
    {
-      infoFormatter_.set_pattern(DEFAULT_PATTERN_ANSII_INFO);
-      warningFormatter_.set_pattern(DEFAULT_PATTERN_ANSII_WARNING);
-      errorFormatter_.set_pattern(DEFAULT_PATTERN_ANSII_ERROR);
-      criticalFormatter_.set_pattern(DEFAULT_PATTERN_ANSII_CRITICAL);
-      defaultFormatter_.set_pattern(DEFAULT_PATTERN_ANSII_DEFAULT);
-   }
+      void Append(spdlog::memory_buf_t& dest, std::string_view text)
+      {
+         dest.append(text.data(), text.data() + text.size());
+      }
 
-   void AnsiiFormatter::format(const spdlog::details::log_msg& msg, spdlog::memory_buf_t& dest)
-   {
-      spdlog::pattern_formatter* formatter{nullptr};
-      switch (msg.level)
+      LineFormatter::LevelLayout GetAnsiiLevelLayout(std::string_view levelCode, std::string_view levelEnd = ANSI_CODE_LOG)
+      {
+         return {std::string(ANSI_CODE_LOG_HEADER),
+                 std::format(" {}[{}", ANSI_CODE_LOG, levelCode),
+                 std::format("{}] ", levelEnd),
+                 std::string(ANSI_CODE_RESET)};
+      }
+
+      std::shared_ptr<const LineFormatter::Layout> GetAnsiiLayout()
+      {
+         static const auto layout = [] {
+            auto result = std::make_shared<LineFormatter::Layout>();
+            result->fill(GetAnsiiLevelLayout(ANSI_CODE_LOG_DEFAULT));
+            (*result)[spdlog::level::info] = GetAnsiiLevelLayout(ANSI_CODE_LOG_INFO);
+            (*result)[spdlog::level::warn] = GetAnsiiLevelLayout(ANSI_CODE_LOG_WARNING);
+            (*result)[spdlog::level::err] = GetAnsiiLevelLayout(ANSI_CODE_LOG_ERROR);
+            (*result)[spdlog::level::critical] = GetAnsiiLevelLayout(ANSI_CODE_LOG_CRITICAL, std::format("{}{}", ANSI_CODE_RESET, ANSI_CODE_LOG));
+            return std::shared_ptr<const LineFormatter::Layout>(std::move(result));
+         }();
+         return layout;
+      }
+
+      std::shared_ptr<const LineFormatter::Layout> GetPlainLayout()
       {
-         case spdlog::level::info:
-            formatter = &infoFormatter_;
-            break;
-         case spdlog::level::warn:
-            formatter = &warningFormatter_;
-            break;
-         case spdlog::level::err:
-            formatter = &errorFormatter_;
-            break;
-         case spdlog::level::critical:
-            formatter = &criticalFormatter_;
-            break;
-         default:
-            formatter = &defaultFormatter_;
-            break;
+         static const auto layout = [] {
+            auto result = std::make_shared<LineFormatter::Layout>();
+            result->fill({"", " [", "] ", ""});
+            return std::shared_ptr<const LineFormatter::Layout>(std::move(result));
+         }();
+         return layout;
       }
+   }
+
+   LineFormatter::LineFormatter(std::shared_ptr<const Layout> layout)
+      : layout_(std::move(layout))
+   {
+   }
 
-      // Use the normal pattern formatter to create the log message with no ansii codes
-      formatter->format(msg, dest);
+   void LineFormatter::format(const spdlog::details::log_msg& msg, spdlog::memory_buf_t& dest)
+   {
+      const auto& level = (*layout_)[static_cast<size_t>(msg.level)];
+      const auto levelName = spdlog::level::to_string_view(msg.level);
+
+      Append(dest, level.beforeTime);
+      Append(dest, GetCachedTimestamp(msg.time));
+      Append(dest, level.beforeLevel);
+      dest.append(levelName.data(), levelName.data() + levelName.size());
+      Append(dest, level.afterLevel);
+      dest.append(msg.payload.data(), msg.payload.data() + msg.payload.size());
+      Append(dest, level.afterMessage);
+      Append(dest, spdlog::details::os::default_eol);
+   }
+
+   std::unique_ptr<spdlog::formatter> LineFormatter::clone() const
+   {
+      return std::make_unique<LineFormatter>(layout_);
+   }
+
+   AnsiiFormatter::AnsiiFormatter()
+      : LineFormatter(GetAnsiiLayout())
+   {
    }
 
-   std::unique_ptr<spdlog::formatter> AnsiiFormatter::clone() const
+   PlainFormatter::PlainFormatter()
+      : LineFormatter(GetPlainLayout())
    {
-      return spdlog::details::make_unique<AnsiiFormatter>();
    }
 }
\ No newline at end of file
@@ -1,25 +1,51 @@
 #pragma once
 
 #include <spdlog/formatter.h>
-#include <spdlog/pattern_formatter.h>
+
+#include <array>
+#include <memory>
+#include <string>
 
 namespace warp
 {
-   // Class used to strip the ansii character strings from a log message
-   class AnsiiFormatter : public spdlog::formatter
+   // Renders DEFAULT_PATTERN lines, "%m/%d/%Y %T [%l] %v", without the spdlog pattern
+   // engine. The timestamp comes from GetCachedTimestamp and the text around it from
+   // a layout per level that is built once and shared by all clones.
+   class LineFormatter : public spdlog::formatter
    {
    public:
-      AnsiiFormatter();
-      virtual ~AnsiiFormatter() = default;
+      // Text written before the timestamp, before and after the level name and after the message
+      struct LevelLayout
+      {
+         std::string beforeTime;
+         std::string beforeLevel;
+         std::string afterLevel;
+         std::string afterMessage;
+      };
+
+      using Layout = std::array<LevelLayout, spdlog::level::n_levels>;
+
+      explicit LineFormatter(std::shared_ptr<const Layout> layout);
+      virtual ~LineFormatter() = default;
 
       void format(const spdlog::details::log_msg& msg, spdlog::memory_buf_t& dest) override;
       std::unique_ptr<spdlog::formatter> clone() const override;
 
    private:
-      spdlog::pattern_formatter infoFormatter_;
-      spdlog::pattern_formatter warningFormatter_;
-      spdlog::pattern_formatter errorFormatter_;
-      spdlog::pattern_formatter criticalFormatter_;
-      spdlog::pattern_formatter defaultFormatter_;
+      std::shared_ptr<const Layout> layout_;
+   };
+
+   // Console lines with the colour codes of each level
+   class AnsiiFormatter : public LineFormatter
+   {
+   public:
+      AnsiiFormatter();
+   };
+
+   // Plain DEFAULT_PATTERN lines for the file sinks
+   class PlainFormatter : public LineFormatter
+   {
+   public:
+      PlainFormatter();
    };
 }
\ No newline at end of file
@@ -0,0 +1,251 @@
+#include "binary-file-sink.h"
+
+#include "deferred-backend.h"
+#include "file-rotation.h"
+
+#include <chrono>
+#include <cstring>
+#include <system_error>
+
+namespace warp
+{
+   namespace
+   {
+      // Call sites are bounded, this guards against format strings built at run time
+      constexpr size_t MAX_TEMPLATES{4096u};
+
+      template <typename T>
+      T ReadArg(const std::byte*& in)
+      {
+         T value;
+         std::memcpy(&value, in, sizeof(T));
+         in += sizeof(T);
+         return value;
+      }
+
+      template <typename Buffer>
+      void AppendByte(Buffer& out, BinaryArgType type, const std::byte*& in)
+      {
+         out.push_back(static_cast<char>(type));
+         out.push_back(static_cast<char>(*in++));
+      }
+
+      template <typename T, typename Buffer>
+      void AppendInteger(Buffer& out, BinaryArgType type, const std::byte*& in)
+      {
+         out.push_back(static_cast<char>(type));
+         const auto value = ReadArg<T>(in);
+         if constexpr (std::is_signed_v<T>) AppendVarint(out, ZigZagEncode(value));
+         else AppendVarint(out, value);
+      }
+
+      template <typename T, typename Buffer>
+      void AppendFloatArg(Buffer& out, BinaryArgType type, const std::byte*& in)
+      {
+         out.push_back(static_cast<char>(type));
+         AppendFloat(out, ReadArg<T>(in));
+      }
+   }
+
+   BinaryFileSink::BinaryFileSink(std::filesystem::path path, const FileLoggingConfig& config)
+      : path_(std::move(path))
+      , config_(config)
+   {
+      // Templates of an earlier run are unknown, start a new file
+      std::error_code ec;
+      if (std::filesystem::file_size(path_, ec) > 0u && !ec)
+      {
+         RotateLogFile(path_, config_);
+      }
+      Open();
+   }
+
+   void BinaryFileSink::LogRecord(const spdlog::details::log_msg& msg, const DeferredRecord& record)
+   {
+      std::lock_guard lock(mutex_);
+      if (size_ >= config_.maxFileSize) Rotate();
+
+      record_.clear();
+      uint32_t id{0};
+      if (FindTemplate(record, id))
+      {
+         // A new template stays in front of the message even if the message falls back to text
+         const auto templateEnd = record_.size();
+
+         BeginRecord(BinaryRecordKind::MESSAGE, msg);
+         AppendVarint(record_, id);
+         const auto header = StripStyles(record.Header());
+         AppendVarint(record_, header.size());
+         record_.append(header.data(), header.data() + header.size());
+
+         if (AppendArgs(record))
+         {
+            WriteRecord();
+            return;
+         }
+         record_.resize(templateEnd);
+      }
+
+      text_.clear();
+      FormatDeferredRecord(record, text_);
+      AppendText(msg, StripStyles(text_));
+      WriteRecord();
+   }
+
+   void BinaryFileSink::sink_it_(const spdlog::details::log_msg& msg)
+   {
+      if (size_ >= config_.maxFileSize) Rotate();
+
+      record_.clear();
+      AppendText(msg, std::string_view(msg.payload.data(), msg.payload.size()));
+      WriteRecord();
+   }
+
+   void BinaryFileSink::flush_()
+   {
+      file_.flush();
+   }
+
+   void BinaryFileSink::set_pattern_(const std::string&)
+   {
+   }
+
+   void BinaryFileSink::set_formatter_(std::unique_ptr<spdlog::formatter>)
+   {
+   }
+
+   void BinaryFileSink::Open()
+   {
+      file_.open(path_.string(), true);
+
+      record_.clear();
+      record_.append(BINARY_LOG_MAGIC.data(), BINARY_LOG_MAGIC.data() + BINARY_LOG_MAGIC.size());
+      record_.push_back(static_cast<char>(BINARY_LOG_VERSION));
+      file_.write(record_);
+
+      size_ = record_.size();
+      lastTime_ = 0;
+      templates_.clear();
+   }
+
+   void BinaryFileSink::Rotate()
+   {
+      file_.close();
+      RotateLogFile(path_, config_);
+      Open();
+   }
+
+   void BinaryFileSink::BeginRecord(BinaryRecordKind kind, const spdlog::details::log_msg& msg)
+   {
+      const auto time = std::chrono::duration_cast<std::chrono::nanoseconds>(msg.time.time_since_epoch()).count();
+      const auto delta = ZigZagEncode(time - lastTime_);
+      lastTime_ = time;
+
+      const auto level = static_cast<uint8_t>(static_cast<uint8_t>(msg.level) & BINARY_LOG_LEVEL_MASK);
+      record_.push_back(static_cast<char>(static_cast<uint8_t>(kind) | level));
+      AppendVarint(record_, delta);
+   }
+
+   void BinaryFileSink::AppendText(const spdlog::details::log_msg& msg, std::string_view text)
+   {
+      BeginRecord(BinaryRecordKind::TEXT, msg);
+      AppendVarint(record_, text.size());
+      record_.append(text.data(), text.data() + text.size());
+   }
+
+   bool BinaryFileSink::AppendArgs(const DeferredRecord& record)
+   {
+      AppendVarint(record_, record.argCount);
+
+      const auto* in = record.Args();
+      for (uint8_t i = 0; i < record.argCount; ++i)
+      {
+         switch (static_cast<DeferredArgTag>(*in++))
+         {
+            case DeferredArgTag::BOOL:
+               AppendByte(record_, BinaryArgType::BOOL, in);
+               break;
+            case DeferredArgTag::CHAR:
+               AppendByte(record_, BinaryArgType::CHAR, in);
+               break;
+            case DeferredArgTag::INT8:
+               AppendByte(record_, BinaryArgType::INT8, in);
+               break;
+            case DeferredArgTag::UINT8:
+               AppendByte(record_, BinaryArgType::UINT8, in);
+               break;
+            case DeferredArgTag::INT16:
+               AppendInteger<int16_t>(record_, BinaryArgType::INT16, in);
+               break;
+            case DeferredArgTag::INT32:
+               AppendInteger<int32_t>(record_, BinaryArgType::INT32, in);
+               break;
+            case DeferredArgTag::INT64:
+               AppendInteger<int64_t>(record_, BinaryArgType::INT64, in);
+               break;
+            case DeferredArgTag::UINT16:
+               AppendInteger<uint16_t>(record_, BinaryArgType::UINT16, in);
+               break;
+            case DeferredArgTag::UINT32:
+               AppendInteger<uint32_t>(record_, BinaryArgType::UINT32, in);
+               break;
+            case DeferredArgTag::UINT64:
+               AppendInteger<uint64_t>(record_, BinaryArgType::UINT64, in);
+               break;
+            case DeferredArgTag::FLOAT:
+               AppendFloatArg<float>(record_, BinaryArgType::FLOAT, in);
+               break;
+            case DeferredArgTag::DOUBLE:
+               AppendFloatArg<double>(record_, BinaryArgType::DOUBLE, in);
+               break;
+            case DeferredArgTag::STRING:
+            {
+               const auto length = ReadArg<uint32_t>(in);
+               const auto text = StripStyles({reinterpret_cast<const char*>(in), length});
+               in += length;
+
+               record_.push_back(static_cast<char>(BinaryArgType::STRING));
+               AppendVarint(record_, text.size());
+               record_.append(text.data(), text.data() + text.size());
+               break;
+            }
+            default:
+               return false;
+         }
+      }
+      return true;
+   }
+
+   bool BinaryFileSink::FindTemplate(const DeferredRecord& record, uint32_t& id)
+   {
+      if (auto iter = templates_.find(record.fmt); iter != templates_.end())
+      {
+         id = iter->second;
+         return true;
+      }
+
+      if (templates_.size() >= MAX_TEMPLATES) return false;
+
+      id = static_cast<uint32_t>(templates_.size());
+      templates_.emplace(record.fmt, id);
+
+      const auto text = StripStyles(record.Format());
+      record_.push_back(static_cast<char>(BinaryRecordKind::TEMPLATE));
+      AppendVarint(record_, id);
+      AppendVarint(record_, text.size());
+      record_.append(text.data(), text.data() + text.size());
+      return true;
+   }
+
+   std::string_view BinaryFileSink::StripStyles(std::string_view text)
+   {
+      styled_.Parse(text);
+      return styled_.Text();
+   }
+
+   void BinaryFileSink::WriteRecord()
+   {
+      file_.write(record_);
+      size_ += record_.size();
+   }
+}
\ No newline at end of file
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "binary-log-format.h"
+#include "styled-dist-sink.h"
+#include "styled-message.h"
+#include "warp/log/log-types.h"
+
+#include <spdlog/details/file_helper.h>
+#include <spdlog/sinks/base_sink.h>
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace warp
+{
+   // Writes messages as a compact record stream instead of text, see binary-log-format.h.
+   // Messages captured with deferred formatting are stored as their call site and
+   // arguments. The format string of a call site is written once per file as a template
+   // and each message only carries its arguments in their native encoding, so nothing is
+   // formatted. Other messages are stored as text. warp-log-decode renders the stream as
+   // DEFAULT_PATTERN text.
+   class BinaryFileSink : public spdlog::sinks::base_sink<std::mutex>, public RecordSink
+   {
+   public:
+      BinaryFileSink(std::filesystem::path path, const FileLoggingConfig& config);
+
+      void LogRecord(const spdlog::details::log_msg& msg, const DeferredRecord& record) override;
+
+   protected:
+      void sink_it_(const spdlog::details::log_msg& msg) override;
+      void flush_() override;
+
+      // Records are not formatted, the pattern is applied when decoding
+      void set_pattern_(const std::string& pattern) override;
+      void set_formatter_(std::unique_ptr<spdlog::formatter> sinkFormatter) override;
+
+   private:
+      void Open();
+      void Rotate();
+
+      // Appends the kind byte and the time delta of the message
+      void BeginRecord(BinaryRecordKind kind, const spdlog::details::log_msg& msg);
+      void AppendText(const spdlog::details::log_msg& msg, std::string_view text);
+
+      // Appends the arguments of the record. Returns false for an argument type it does not know.
+      bool AppendArgs(const DeferredRecord& record);
+
+      // Returns the id of the template of the call site, appending its definition to the
+      // record if it is new. Returns false once the file has no room for more templates.
+      bool FindTemplate(const DeferredRecord& record, uint32_t& id);
+
+      // Returns the text without style codes, valid until the next call
+      std::string_view StripStyles(std::string_view text);
+
+      void WriteRecord();
+
+      std::filesystem::path path_;
+      FileLoggingConfig config_;
+      spdlog::details::file_helper file_;
+      size_t size_{0};
+      int64_t lastTime_{0};
+
+      // Keyed by the format string of the call site
+      std::unordered_map<const char*, uint32_t> templates_;
+      StyledMessage styled_;
+      std::string text_;
+      spdlog::memory_buf_t record_;
+   };
+}
\ No newline at end of file
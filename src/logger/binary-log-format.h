@@ -0,0 +1,115 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include <type_traits>
+
+namespace warp
+{
+   // Record stream written by BinaryFileSink and read back by warp-log-decode.
+   //
+   // A file starts with BINARY_LOG_MAGIC and BINARY_LOG_VERSION. Every record starts
+   // with a kind byte that carries the spdlog level of a message in its low bits:
+   //   TEMPLATE  varint id, varint length, std::format string of a call site
+   //   MESSAGE   varint time delta, varint template id, varint header length, header,
+   //             varint count, per argument a BinaryArgType byte and the value
+   //   TEXT      varint time delta, varint length, text
+   // Time deltas are zigzag encoded nanoseconds since the previous message of the
+   // file. Template ids are only valid in the file that defined them. BOOL, CHAR,
+   // INT8 and UINT8 values take a byte, other integers a varint, zigzag encoded if
+   // signed. FLOAT and DOUBLE are their IEEE bytes in little endian order, STRING a
+   // varint length and the text.
+   inline constexpr std::string_view BINARY_LOG_MAGIC{"WLOG"};
+   inline constexpr uint8_t BINARY_LOG_VERSION{2};
+
+   enum class BinaryRecordKind : uint8_t
+   {
+      TEMPLATE = 0x10,
+      MESSAGE = 0x20,
+      TEXT = 0x30
+   };
+
+   enum class BinaryArgType : uint8_t
+   {
+      BOOL,
+      CHAR,
+      INT8,
+      INT16,
+      INT32,
+      INT64,
+      UINT8,
+      UINT16,
+      UINT32,
+      UINT64,
+      FLOAT,
+      DOUBLE,
+      STRING
+   };
+
+   inline constexpr uint8_t BINARY_LOG_KIND_MASK{0xF0};
+   inline constexpr uint8_t BINARY_LOG_LEVEL_MASK{0x0F};
+
+   template <typename Buffer>
+   void AppendVarint(Buffer& out, uint64_t value)
+   {
+      while (value >= 0x80u)
+      {
+         out.push_back(static_cast<char>((value & 0x7Fu) | 0x80u));
+         value >>= 7;
+      }
+      out.push_back(static_cast<char>(value));
+   }
+
+   // Returns false if the data ends inside the varint
+   inline bool ReadVarint(std::string_view data, size_t& pos, uint64_t& value)
+   {
+      value = 0u;
+      for (unsigned shift = 0u; pos < data.size() && shift < 64u; shift += 7u)
+      {
+         const auto byte = static_cast<uint8_t>(data[pos++]);
+         value |= static_cast<uint64_t>(byte & 0x7Fu) << shift;
+         if ((byte & 0x80u) == 0u) return true;
+      }
+      return false;
+   }
+
+   constexpr uint64_t ZigZagEncode(int64_t value)
+   {
+      return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+   }
+
+   constexpr int64_t ZigZagDecode(uint64_t value)
+   {
+      return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1u);
+   }
+
+   // Appends the bytes of a float or double in little endian order
+   template <typename Buffer, typename Float>
+   void AppendFloat(Buffer& out, Float value)
+   {
+      using Bits = std::conditional_t<sizeof(Float) == 4, uint32_t, uint64_t>;
+      Bits bits{0};
+      std::memcpy(&bits, &value, sizeof(bits));
+      for (size_t i = 0; i < sizeof(bits); ++i)
+      {
+         out.push_back(static_cast<char>((bits >> (8u * i)) & 0xFFu));
+      }
+   }
+
+   // Returns false if the data ends inside the value
+   template <typename Float>
+   bool ReadFloat(std::string_view data, size_t& pos, Float& value)
+   {
+      using Bits = std::conditional_t<sizeof(Float) == 4, uint32_t, uint64_t>;
+      if (data.size() - pos < sizeof(Bits)) return false;
+
+      Bits bits{0};
+      for (size_t i = 0; i < sizeof(bits); ++i)
+      {
+         bits |= static_cast<Bits>(static_cast<uint8_t>(data[pos++])) << (8u * i);
+      }
+      std::memcpy(&value, &bits, sizeof(bits));
+      return true;
+   }
+}
\ No newline at end of file
@@ -0,0 +1,91 @@
+#include "console-sink.h"
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <cerrno>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+
+namespace warp
+{
+   ConsoleSink::ConsoleSink()
+   {
+#if defined(_WIN32)
+      output_ = GetStdHandle(STD_OUTPUT_HANDLE);
+
+      // The lines carry ANSI codes, let the console render them
+      DWORD mode{0};
+      if (GetConsoleMode(output_, &mode))
+      {
+         SetConsoleMode(output_, mode | ENABLE_VIRTUAL_TERMINAL_PROCESSING);
+      }
+#else
+      output_ = STDOUT_FILENO;
+#endif
+   }
+
+   ConsoleSink::~ConsoleSink()
+   {
+      std::lock_guard lock(mutex_);
+      Write();
+   }
+
+   void ConsoleSink::EndBatch()
+   {
+      std::lock_guard lock(mutex_);
+      Write();
+   }
+
+   void ConsoleSink::sink_it_(const spdlog::details::log_msg& msg)
+   {
+      formatter_->format(msg, buffer_);
+   }
+
+   void ConsoleSink::flush_()
+   {
+      Write();
+   }
+
+#if defined(_WIN32)
+   void ConsoleSink::Write()
+   {
+      const char* data = buffer_.data();
+      size_t remaining = buffer_.size();
+      while (remaining > 0u)
+      {
+         DWORD written{0};
+         const auto chunk = static_cast<DWORD>(std::min<size_t>(remaining, MAXDWORD));
+         if (!WriteFile(output_, data, chunk, &written, nullptr) || written == 0) break;
+
+         data += written;
+         remaining -= written;
+      }
+      buffer_.clear();
+   }
+#else
+   void ConsoleSink::Write()
+   {
+      const char* data = buffer_.data();
+      size_t remaining = buffer_.size();
+      while (remaining > 0u)
+      {
+         const auto written = ::write(output_, data, remaining);
+         if (written < 0 && errno == EINTR) continue;
+         if (written <= 0) break;
+
+         data += written;
+         remaining -= static_cast<size_t>(written);
+      }
+      buffer_.clear();
+   }
+#endif
+}
\ No newline at end of file
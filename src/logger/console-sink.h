@@ -0,0 +1,35 @@
+#pragma once
+
+#include "styled-dist-sink.h"
+
+#include <spdlog/sinks/base_sink.h>
+
+#include <mutex>
+
+namespace warp
+{
+   // Writes formatted lines to stdout. Lines of a batch collect in one buffer that
+   // goes out with a single write call when the batch ends, instead of a write per line.
+   class ConsoleSink : public spdlog::sinks::base_sink<std::mutex>, public BatchSink
+   {
+   public:
+      ConsoleSink();
+      ~ConsoleSink() override;
+
+      void EndBatch() override;
+
+   protected:
+      void sink_it_(const spdlog::details::log_msg& msg) override;
+      void flush_() override;
+
+   private:
+      void Write();
+
+#if defined(_WIN32)
+      void* output_{nullptr};
+#else
+      int output_{1};
+#endif
+      spdlog::memory_buf_t buffer_;
+   };
+}
\ No newline at end of file
@@ -0,0 +1,222 @@
+#include "datagram-sink.h"
+
+#include "binary-log-format.h"
+
+#include <spdlog/common.h>
+
+#include <format>
+
+#if !defined(_WIN32)
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+namespace warp
+{
+   namespace
+   {
+      constexpr auto RECONNECT_INTERVAL{std::chrono::seconds(1)};
+
+#if defined(MSG_NOSIGNAL)
+      constexpr int SEND_FLAGS{MSG_DONTWAIT | MSG_NOSIGNAL};
+#elif !defined(_WIN32)
+      constexpr int SEND_FLAGS{MSG_DONTWAIT};
+#endif
+   }
+
+   DatagramSink::DatagramSink(const DatagramLoggingConfig& config)
+      : config_(config)
+   {
+#if defined(_WIN32)
+      spdlog::throw_spdlog_ex("Unix datagram sockets are not supported on Windows");
+#else
+      if (config_.socketPath.native().size() >= sizeof(sockaddr_un::sun_path))
+      {
+         spdlog::throw_spdlog_ex(std::format("Socket path {} is too long", config_.socketPath.string()));
+      }
+#endif
+   }
+
+   DatagramSink::~DatagramSink()
+   {
+      std::lock_guard lock(mutex_);
+      Send();
+      Disconnect();
+   }
+
+   void DatagramSink::LogStructured(const spdlog::details::log_msg& msg, const StyledMessage& message)
+   {
+      std::lock_guard lock(mutex_);
+      Append(msg, &message);
+   }
+
+   void DatagramSink::EndBatch()
+   {
+      std::lock_guard lock(mutex_);
+      Send();
+   }
+
+   DatagramStats DatagramSink::GetStats() const
+   {
+      return {
+         .socketPath = config_.socketPath.string(),
+         .datagrams = datagrams_,
+         .records = records_,
+         .dropped = dropped_
+      };
+   }
+
+   void DatagramSink::sink_it_(const spdlog::details::log_msg& msg)
+   {
+      Append(msg, nullptr);
+   }
+
+   void DatagramSink::flush_()
+   {
+      Send();
+   }
+
+   void DatagramSink::set_pattern_(const std::string&)
+   {
+   }
+
+   void DatagramSink::set_formatter_(std::unique_ptr<spdlog::formatter>)
+   {
+   }
+
+   void DatagramSink::Append(const spdlog::details::log_msg& msg, const StyledMessage* message)
+   {
+      Encode(msg, message);
+
+      // Binary records are encoded against the start of their datagram
+      if (pendingRecords_ > 0u && datagram_.size() + record_.size() > config_.maxDatagramSize)
+      {
+         Send();
+         Encode(msg, message);
+      }
+
+      datagram_.append(record_.data(), record_.data() + record_.size());
+      ++pendingRecords_;
+
+      // A record too large to share a datagram goes out alone
+      if (datagram_.size() >= config_.maxDatagramSize) Send();
+   }
+
+   void DatagramSink::Encode(const spdlog::details::log_msg& msg, const StyledMessage* message)
+   {
+      record_.clear();
+      if (config_.format == LogDatagramFormat::JSON)
+      {
+         json_.Encode(msg, message, record_);
+         return;
+      }
+
+      // Each datagram is a stream of its own, a lost one must not break the next
+      if (pendingRecords_ == 0u)
+      {
+         datagram_.clear();
+         datagram_.append(BINARY_LOG_MAGIC.data(), BINARY_LOG_MAGIC.data() + BINARY_LOG_MAGIC.size());
+         datagram_.push_back(static_cast<char>(BINARY_LOG_VERSION));
+         lastTime_ = 0;
+      }
+
+      const auto time = std::chrono::duration_cast<std::chrono::nanoseconds>(msg.time.time_since_epoch()).count();
+      const auto level = static_cast<uint8_t>(static_cast<uint8_t>(msg.level) & BINARY_LOG_LEVEL_MASK);
+
+      record_.push_back(static_cast<char>(static_cast<uint8_t>(BinaryRecordKind::TEXT) | level));
+      AppendVarint(record_, ZigZagEncode(time - lastTime_));
+      AppendVarint(record_, msg.payload.size());
+      record_.append(msg.payload.data(), msg.payload.data() + msg.payload.size());
+      lastTime_ = time;
+   }
+
+#if defined(_WIN32)
+   void DatagramSink::Send()
+   {
+      dropped_ += pendingRecords_;
+      pendingRecords_ = 0u;
+      datagram_.clear();
+   }
+
+   bool DatagramSink::Connect()
+   {
+      return false;
+   }
+
+   void DatagramSink::Disconnect()
+   {
+   }
+#else
+   void DatagramSink::Send()
+   {
+      if (pendingRecords_ == 0u) return;
+
+      const auto records = pendingRecords_;
+      pendingRecords_ = 0u;
+
+      if (!Connect())
+      {
+         dropped_ += records;
+         datagram_.clear();
+         return;
+      }
+
+      if (::send(socket_, datagram_.data(), datagram_.size(), SEND_FLAGS) < 0)
+      {
+         dropped_ += records;
+
+         // A full buffer or an oversized datagram only costs this one, anything else
+         // means the collector went away
+         if (errno != EAGAIN && errno != EWOULDBLOCK && errno != ENOBUFS && errno != EMSGSIZE && errno != EINTR)
+         {
+            Disconnect();
+         }
+      }
+      else
+      {
+         ++datagrams_;
+         records_ += records;
+      }
+      datagram_.clear();
+   }
+
+   bool DatagramSink::Connect()
+   {
+      if (socket_ >= 0) return true;
+
+      const auto now = std::chrono::steady_clock::now();
+      if (now < nextConnect_) return false;
+      nextConnect_ = now + RECONNECT_INTERVAL;
+
+      socket_ = ::socket(AF_UNIX, SOCK_DGRAM, 0);
+      if (socket_ < 0) return false;
+
+      ::fcntl(socket_, F_SETFD, FD_CLOEXEC);
+      ::fcntl(socket_, F_SETFL, ::fcntl(socket_, F_GETFL) | O_NONBLOCK);
+
+      sockaddr_un address{};
+      address.sun_family = AF_UNIX;
+      const auto& path = config_.socketPath.native();
+      std::memcpy(address.sun_path, path.data(), path.size());
+
+      if (::connect(socket_, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0)
+      {
+         Disconnect();
+         return false;
+      }
+      return true;
+   }
+
+   void DatagramSink::Disconnect()
+   {
+      if (socket_ < 0) return;
+
+      ::close(socket_);
+      socket_ = -1;
+   }
+#endif
+}
\ No newline at end of file
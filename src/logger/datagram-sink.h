@@ -0,0 +1,64 @@
+#pragma once
+
+#include "json-record-encoder.h"
+#include "styled-dist-sink.h"
+#include "warp/log/log-types.h"
+
+#include <spdlog/sinks/base_sink.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace warp
+{
+   // Ships records to a local collector over a Unix datagram socket. The records of a
+   // batch are packed into as few datagrams as fit, sends never block. Records the
+   // socket does not take are counted as dropped, so the logging worker never waits
+   // for the collector. The socket connects lazily and retries once per second.
+   class DatagramSink : public spdlog::sinks::base_sink<std::mutex>, public StructuredSink, public BatchSink
+   {
+   public:
+      explicit DatagramSink(const DatagramLoggingConfig& config);
+      ~DatagramSink() override;
+
+      void LogStructured(const spdlog::details::log_msg& msg, const StyledMessage& message) override;
+      void EndBatch() override;
+
+      [[nodiscard]] DatagramStats GetStats() const;
+
+   protected:
+      // Messages logged without fields
+      void sink_it_(const spdlog::details::log_msg& msg) override;
+      void flush_() override;
+
+      // The layout is fixed, patterns do not apply
+      void set_pattern_(const std::string& pattern) override;
+      void set_formatter_(std::unique_ptr<spdlog::formatter> sinkFormatter) override;
+
+   private:
+      void Append(const spdlog::details::log_msg& msg, const StyledMessage* message);
+      void Encode(const spdlog::details::log_msg& msg, const StyledMessage* message);
+      void Send();
+
+      bool Connect();
+      void Disconnect();
+
+      DatagramLoggingConfig config_;
+      int socket_{-1};
+      std::chrono::steady_clock::time_point nextConnect_;
+
+      spdlog::memory_buf_t datagram_;
+      spdlog::memory_buf_t record_;
+      uint64_t pendingRecords_{0};
+      int64_t lastTime_{0};
+      JsonRecordEncoder json_;
+
+      std::atomic<uint64_t> datagrams_{0};
+      std::atomic<uint64_t> records_{0};
+      std::atomic<uint64_t> dropped_{0};
+   };
+}
\ No newline at end of file
@@ -0,0 +1,225 @@
+#include "deferred-backend.h"
+
+#include <algorithm>
+#include <chrono>
+#include <exception>
+#include <format>
+#include <limits>
+
+namespace warp
+{
+   namespace
+   {
+      // Records written per wake up before the backend checks for a stop request
+      constexpr size_t DRAIN_BATCH_SIZE{256u};
+
+      // How long the backend sleeps when every ring is empty
+      constexpr std::chrono::milliseconds IDLE_WAIT{1};
+
+      // Longest a producer with a full ring sleeps before it tries again. Bounds the
+      // wait when a drain finished just before the producer started waiting.
+      constexpr std::chrono::milliseconds SPACE_WAIT{1};
+
+      // Stamps of different clocks only meet right after the clock source changed
+      bool CapturedBefore(const DeferredRecord& record, const DeferredRecord& other)
+      {
+         if (((record.flags ^ other.flags) & DeferredRecord::FLAG_TSC) == 0) return record.time < other.time;
+         return record.TimeNanoseconds() < other.TimeNanoseconds();
+      }
+
+      // Releases the ring of a thread when the thread exits. The backend drops it once drained.
+      struct ThreadRingHolder
+      {
+         const DeferredBackend* owner{nullptr};
+         std::shared_ptr<DeferredRing> ring;
+
+         ~ThreadRingHolder()
+         {
+            if (ring) ring->closed = true;
+         }
+      };
+
+      thread_local ThreadRingHolder threadRing;
+
+      // Set while the thread drains. A record the handler logs is left to the running drain.
+      thread_local bool draining{false};
+   }
+
+   DeferredBackend::DeferredBackend(size_t ringCapacity, Handler handler)
+      : ringCapacity_(ringCapacity)
+      , handler_(std::move(handler))
+   {
+   }
+
+   DeferredBackend::~DeferredBackend()
+   {
+      Stop();
+   }
+
+   void DeferredBackend::SetThreadSetup(std::function<void()> setup)
+   {
+      threadSetup_ = std::move(setup);
+   }
+
+   void DeferredBackend::Start()
+   {
+      if (running_.exchange(true)) return;
+
+      thread_ = std::make_unique<std::jthread>([this](std::stop_token stopToken) {
+         if (threadSetup_) threadSetup_();
+         Work(stopToken);
+      });
+   }
+
+   void DeferredBackend::Stop()
+   {
+      if (!running_.exchange(false)) return;
+
+      {
+         std::scoped_lock lock(spaceLock_);
+         spaceFreed_.notify_all();
+      }
+
+      thread_->request_stop();
+      thread_->join();
+      thread_.reset();
+
+      // Catch anything a producer wrote while the backend was shutting down. Pairs with
+      // the fence of a producer: a record this drain misses is written by its producer.
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      std::scoped_lock lock(drainLock_);
+      Drain(std::numeric_limits<size_t>::max());
+   }
+
+   bool DeferredBackend::Running() const
+   {
+      return running_;
+   }
+
+   DeferredRing& DeferredBackend::GetThreadRing()
+   {
+      if (threadRing.owner != this || !threadRing.ring)
+      {
+         if (threadRing.ring) threadRing.ring->closed = true;
+
+         threadRing.owner = this;
+         threadRing.ring = RegisterRing();
+      }
+      return *threadRing.ring;
+   }
+
+   bool DeferredBackend::WaitForSpace()
+   {
+      if (!running_) return false;
+
+      std::unique_lock lock(spaceLock_);
+      const auto drains = drains_;
+      spaceWaiters_.fetch_add(1);
+      wakeup_.notify_one();
+      spaceFreed_.wait_for(lock, SPACE_WAIT, [this, drains] { return drains_ != drains || !running_; });
+      spaceWaiters_.fetch_sub(1);
+      return running_;
+   }
+
+   void DeferredBackend::Flush()
+   {
+      if (draining) return;
+
+      std::scoped_lock lock(drainLock_);
+      if (!running_) Drain(std::numeric_limits<size_t>::max());
+   }
+
+   std::shared_ptr<DeferredRing> DeferredBackend::RegisterRing()
+   {
+      auto ring = std::make_shared<DeferredRing>(ringCapacity_);
+
+      std::scoped_lock lock(ringsLock_);
+      rings_.push_back(ring);
+      return ring;
+   }
+
+   void DeferredBackend::Work(std::stop_token stopToken)
+   {
+      while (!stopToken.stop_requested())
+      {
+         size_t written{0u};
+         {
+            std::scoped_lock lock(drainLock_);
+            written = Drain(DRAIN_BATCH_SIZE);
+         }
+
+         if (written == 0u)
+         {
+            std::unique_lock lock(waitLock_);
+            wakeup_.wait_for(lock, stopToken, IDLE_WAIT, [] { return false; });
+         }
+      }
+   }
+
+   void FormatDeferredRecord(const DeferredRecord& record, std::string& out)
+   {
+      if (record.flags & DeferredRecord::FLAG_HEADER)
+      {
+         out.append(record.Header());
+         out.append(": ");
+      }
+
+      try
+      {
+         record.format(record.Format(), record.Args(), out);
+      }
+      catch (const std::exception& e)
+      {
+         out.append(std::format("[format error: {}]", e.what()));
+      }
+   }
+
+   size_t DeferredBackend::Drain(size_t maxRecords)
+   {
+      {
+         std::scoped_lock lock(ringsLock_);
+         drainRings_ = rings_;
+      }
+      draining = true;
+
+      size_t written{0u};
+      while (written < maxRecords)
+      {
+         // Merge the rings by capture time so the output stays in order across threads
+         DeferredRing* nextRing{nullptr};
+         const DeferredRecord* next{nullptr};
+         for (auto& ring : drainRings_)
+         {
+            auto* record = ring->Peek();
+            if (record != nullptr && (next == nullptr || CapturedBefore(*record, *next)))
+            {
+               nextRing = ring.get();
+               next = record;
+            }
+         }
+
+         if (next == nullptr) break;
+
+         handler_(*next);
+         nextRing->Pop(next);
+         ++written;
+      }
+
+      drainRings_.clear();
+      draining = false;
+
+      if (written > 0u && spaceWaiters_.load() > 0u)
+      {
+         std::scoped_lock lock(spaceLock_);
+         ++drains_;
+         spaceFreed_.notify_all();
+      }
+
+      std::scoped_lock lock(ringsLock_);
+      std::erase_if(rings_, [](const auto& ring) {
+         return ring->closed && ring->Empty();
+      });
+
+      return written;
+   }
+}
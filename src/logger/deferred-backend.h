@@ -0,0 +1,83 @@
+#pragma once
+
+#include "warp/log/log-deferred.h"
+
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace warp
+{
+   // Appends the header and the formatted arguments of the record to the output
+   void FormatDeferredRecord(const DeferredRecord& record, std::string& out);
+
+   // Drains the per thread deferred rings on a dedicated thread and hands each
+   // record to the logger in capture order. The sinks format it if they need text.
+   class DeferredBackend
+   {
+   public:
+      using Handler = std::function<void(const DeferredRecord& record)>;
+
+      DeferredBackend(size_t ringCapacity, Handler handler);
+      ~DeferredBackend();
+
+      // Called on the backend thread when it starts, for example to name it
+      void SetThreadSetup(std::function<void()> setup);
+
+      void Start();
+
+      // Stops the backend thread after all pending records were written
+      void Stop();
+
+      [[nodiscard]] bool Running() const;
+
+      // Returns the ring owned by the calling thread, creating it on first use
+      DeferredRing& GetThreadRing();
+
+      // Called by a producer whose ring is full. Sleeps until the backend drained
+      // records or a short timeout passed. Returns false if the backend is not
+      // running and the producer should log directly instead.
+      bool WaitForSpace();
+
+      // Writes pending records on the calling thread if the backend is stopped. Called by
+      // a producer that committed a record after the final drain of Stop.
+      void Flush();
+
+   private:
+      void Work(std::stop_token stopToken);
+
+      // Writes pending records across all rings in time order. Returns the number written.
+      // Only one thread drains at a time, the caller holds drainLock_.
+      size_t Drain(size_t maxRecords);
+
+      std::shared_ptr<DeferredRing> RegisterRing();
+
+      size_t ringCapacity_;
+      Handler handler_;
+      std::function<void()> threadSetup_;
+
+      std::mutex ringsLock_;
+      std::vector<std::shared_ptr<DeferredRing>> rings_;
+
+      // The handler runs under drainLock_ only, so producers can register rings meanwhile
+      std::mutex drainLock_;
+      std::vector<std::shared_ptr<DeferredRing>> drainRings_;
+
+      std::mutex waitLock_;
+      std::condition_variable_any wakeup_;
+
+      // Producers waiting for room, woken after a drain that wrote records
+      std::mutex spaceLock_;
+      std::condition_variable spaceFreed_;
+      std::atomic<uint32_t> spaceWaiters_{0};
+      uint64_t drains_{0};
+
+      std::atomic_bool running_{false};
+      std::unique_ptr<std::jthread> thread_;
+   };
+}
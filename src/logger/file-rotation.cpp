@@ -0,0 +1,59 @@
+#include "file-rotation.h"
+
+#include "log-compressor.h"
+#include "log-index.h"
+
+#include <format>
+#include <system_error>
+
+namespace warp
+{
+   std::filesystem::path RotatedLogPath(const std::filesystem::path& path, size_t index, std::string_view suffix)
+   {
+      auto name = path.filename();
+      if (index > 0u)
+      {
+         name = path.stem();
+         name += std::format(".{}", index);
+         name += path.extension();
+      }
+      name += suffix;
+      return path.parent_path() / name;
+   }
+
+   void RotateLogFiles(const std::filesystem::path& path, size_t maxFiles, std::string_view suffix, size_t firstIndex)
+   {
+      // The time index of a file moves with it
+      const std::string indexSuffix = std::format("{}{}", suffix, LOG_INDEX_SUFFIX);
+
+      std::error_code ec;
+      for (const std::string_view fileSuffix : {suffix, std::string_view(indexSuffix)})
+      {
+         for (auto i = maxFiles; i > firstIndex; --i)
+         {
+            const auto src = RotatedLogPath(path, i - 1u, fileSuffix);
+            if (!std::filesystem::exists(src, ec)) continue;
+
+            const auto target = RotatedLogPath(path, i, fileSuffix);
+            std::filesystem::remove(target, ec);
+            std::filesystem::rename(src, target, ec);
+         }
+
+         if (maxFiles == 0u && firstIndex == 0u)
+         {
+            std::filesystem::remove(RotatedLogPath(path, 0u, fileSuffix), ec);
+         }
+      }
+   }
+
+   void RotateLogFile(const std::filesystem::path& path, const FileLoggingConfig& config)
+   {
+      if (!config.compressRotated || config.maxFiles == 0u)
+      {
+         RotateLogFiles(path, config.maxFiles);
+         return;
+      }
+
+      LogCompressor::Instance().Rotate(path, config);
+   }
+}
\ No newline at end of file
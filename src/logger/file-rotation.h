@@ -0,0 +1,24 @@
+#pragma once
+
+#include "warp/log/log-types.h"
+
+#include <cstddef>
+#include <filesystem>
+#include <string_view>
+
+namespace warp
+{
+   // Returns the name of a rotated log file, log.txt -> log.1.txt. Index 0 is the file itself.
+   // The suffix is appended, log.1.txt.gz for compressed files.
+   std::filesystem::path RotatedLogPath(const std::filesystem::path& path, size_t index, std::string_view suffix = {});
+
+   // Shifts log.txt -> log.1.txt -> ... -> log.N.txt like spdlog's rotating_file_sink.
+   // The oldest file is removed and the file itself no longer exists afterwards.
+   // Time indexes, log.txt.idx, are shifted along. From a first index of 1 the file
+   // itself stays in place and only the rotated files move up.
+   void RotateLogFiles(const std::filesystem::path& path, size_t maxFiles, std::string_view suffix = {}, size_t firstIndex = 0u);
+
+   // Rotates the closed log file as the config asks for. With compressRotated the file
+   // is moved aside and the compressor adds it to the log.N.txt.gz files later.
+   void RotateLogFile(const std::filesystem::path& path, const FileLoggingConfig& config);
+}
\ No newline at end of file
@@ -2,17 +2,10 @@
 
 #include "warp/log/log-types.h"
 
-#include <format>
 #include <string>
 
 namespace warp
 {
-   // Log pattern to be used by the logger
+   // Log pattern to be used by the logger. LineFormatter renders it without the pattern engine.
    inline const std::string DEFAULT_PATTERN{"%m/%d/%Y %T [%l] %v"};
-
-   inline const std::string DEFAULT_PATTERN_ANSII_INFO{std::format("{}%m/%d/%Y %T {}[{}%l{}] %v{}", ANSI_CODE_LOG_HEADER, ANSI_CODE_LOG, ANSI_CODE_LOG_INFO, ANSI_CODE_LOG, ANSI_CODE_RESET)};
-   inline const std::string DEFAULT_PATTERN_ANSII_WARNING{std::format("{}%m/%d/%Y %T {}[{}%l{}] %v{}", ANSI_CODE_LOG_HEADER, ANSI_CODE_LOG, ANSI_CODE_LOG_WARNING, ANSI_CODE_LOG, ANSI_CODE_RESET)};
-   inline const std::string DEFAULT_PATTERN_ANSII_ERROR{std::format("{}%m/%d/%Y %T {}[{}%l{}] %v{}", ANSI_CODE_LOG_HEADER, ANSI_CODE_LOG, ANSI_CODE_LOG_ERROR, ANSI_CODE_LOG, ANSI_CODE_RESET)};
-   inline const std::string DEFAULT_PATTERN_ANSII_CRITICAL{std::format("{}%m/%d/%Y %T {}[{}%l{}{}] %v{}", ANSI_CODE_LOG_HEADER, ANSI_CODE_LOG, ANSI_CODE_LOG_CRITICAL, ANSI_CODE_RESET, ANSI_CODE_LOG, ANSI_CODE_RESET)};
-   inline const std::string DEFAULT_PATTERN_ANSII_DEFAULT{std::format("{}%m/%d/%Y %T {}[{}%l{}] %v{}", ANSI_CODE_LOG_HEADER, ANSI_CODE_LOG, ANSI_CODE_LOG_DEFAULT, ANSI_CODE_LOG, ANSI_CODE_RESET)};
 }
\ No newline at end of file
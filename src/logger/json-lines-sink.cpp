@@ -0,0 +1,55 @@
+#include "json-lines-sink.h"
+
+#include "file-rotation.h"
+
+namespace warp
+{
+   JsonLinesSink::JsonLinesSink(std::filesystem::path path, const FileLoggingConfig& config)
+      : path_(std::move(path))
+      , config_(config)
+   {
+      file_.open(path_.string(), false);
+      size_ = file_.size();
+   }
+
+   void JsonLinesSink::LogStructured(const spdlog::details::log_msg& msg, const StyledMessage& message)
+   {
+      std::lock_guard lock(mutex_);
+      Write(msg, &message);
+   }
+
+   void JsonLinesSink::sink_it_(const spdlog::details::log_msg& msg)
+   {
+      Write(msg, nullptr);
+   }
+
+   void JsonLinesSink::flush_()
+   {
+      file_.flush();
+   }
+
+   void JsonLinesSink::set_pattern_(const std::string&)
+   {
+   }
+
+   void JsonLinesSink::set_formatter_(std::unique_ptr<spdlog::formatter>)
+   {
+   }
+
+   void JsonLinesSink::Write(const spdlog::details::log_msg& msg, const StyledMessage* message)
+   {
+      if (size_ >= config_.maxFileSize)
+      {
+         file_.close();
+         RotateLogFile(path_, config_);
+         file_.open(path_.string(), true);
+         size_ = 0u;
+      }
+
+      line_.clear();
+      encoder_.Encode(msg, message, line_);
+
+      file_.write(line_);
+      size_ += line_.size();
+   }
+}
\ No newline at end of file
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "json-record-encoder.h"
+#include "styled-dist-sink.h"
+#include "styled-message.h"
+#include "warp/log/log-types.h"
+
+#include <spdlog/details/file_helper.h>
+#include <spdlog/sinks/base_sink.h>
+
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+
+namespace warp
+{
+   // Writes one JSON object per message, see JsonRecordEncoder, so the log can be
+   // ingested without parsing the text
+   class JsonLinesSink : public spdlog::sinks::base_sink<std::mutex>, public StructuredSink
+   {
+   public:
+      JsonLinesSink(std::filesystem::path path, const FileLoggingConfig& config);
+
+      void LogStructured(const spdlog::details::log_msg& msg, const StyledMessage& message) override;
+
+   protected:
+      // Messages logged without fields
+      void sink_it_(const spdlog::details::log_msg& msg) override;
+      void flush_() override;
+
+      // The layout is fixed, patterns do not apply
+      void set_pattern_(const std::string& pattern) override;
+      void set_formatter_(std::unique_ptr<spdlog::formatter> sinkFormatter) override;
+
+   private:
+      void Write(const spdlog::details::log_msg& msg, const StyledMessage* message);
+
+      std::filesystem::path path_;
+      FileLoggingConfig config_;
+      spdlog::details::file_helper file_;
+      size_t size_{0};
+
+      // Reused for every line
+      spdlog::memory_buf_t line_;
+      JsonRecordEncoder encoder_;
+   };
+}
\ No newline at end of file
@@ -0,0 +1,101 @@
+#include "json-record-encoder.h"
+
+#include <glaze/glaze.hpp>
+
+#include <chrono>
+#include <format>
+#include <iterator>
+
+namespace warp
+{
+   namespace
+   {
+      // Formatted numbers can still be hex, inf or nan, which JSON has no number for
+      bool IsJsonNumber(std::string_view text)
+      {
+         size_t pos{0};
+         auto digits = [&text, &pos] {
+            const auto start = pos;
+            while (pos < text.size() && text[pos] >= '0' && text[pos] <= '9') ++pos;
+            return pos > start;
+         };
+
+         if (pos < text.size() && text[pos] == '-') ++pos;
+         if (!digits()) return false;
+         if (pos < text.size() && text[pos] == '.')
+         {
+            ++pos;
+            if (!digits()) return false;
+         }
+         if (pos < text.size() && (text[pos] == 'e' || text[pos] == 'E'))
+         {
+            ++pos;
+            if (pos < text.size() && (text[pos] == '+' || text[pos] == '-')) ++pos;
+            if (!digits()) return false;
+         }
+         return pos == text.size();
+      }
+
+      void Append(spdlog::memory_buf_t& out, std::string_view text)
+      {
+         out.append(text.data(), text.data() + text.size());
+      }
+   }
+
+   void JsonRecordEncoder::Encode(const spdlog::details::log_msg& msg, const StyledMessage* message, spdlog::memory_buf_t& out)
+   {
+      std::format_to(std::back_inserter(out), R"({{"time":"{:%FT%T}Z","level":)",
+                     std::chrono::floor<std::chrono::microseconds>(msg.time));
+
+      const auto level = spdlog::level::to_string_view(msg.level);
+      AppendString(std::string_view(level.data(), level.size()), out);
+
+      Append(out, R"(,"message":)");
+      AppendString(std::string_view(msg.payload.data(), msg.payload.size()), out);
+
+      if (message != nullptr && !message->Fields().empty())
+      {
+         Append(out, R"(,"fields":{)");
+
+         bool first{true};
+         for (const auto& field : message->Fields())
+         {
+            if (!first) out.push_back(',');
+            first = false;
+
+            AppendString(message->Key(field), out);
+            out.push_back(':');
+            AppendValue(field.type, message->Value(field), out);
+         }
+         out.push_back('}');
+      }
+
+      out.push_back('}');
+      out.push_back('\n');
+   }
+
+   void JsonRecordEncoder::AppendString(std::string_view text, spdlog::memory_buf_t& out)
+   {
+      // glaze quotes and escapes the text
+      if (glz::write_json(text, escaped_))
+      {
+         escaped_ = R"("")";
+      }
+      Append(out, escaped_);
+   }
+
+   void JsonRecordEncoder::AppendValue(LogFieldType type, std::string_view value, spdlog::memory_buf_t& out)
+   {
+      const bool raw = (type == LogFieldType::BOOL && (value == "true" || value == "false"))
+         || ((type == LogFieldType::INT || type == LogFieldType::UINT || type == LogFieldType::FLOAT) && IsJsonNumber(value));
+
+      if (raw)
+      {
+         Append(out, value);
+      }
+      else
+      {
+         AppendString(value, out);
+      }
+   }
+}
\ No newline at end of file
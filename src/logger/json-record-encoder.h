@@ -0,0 +1,28 @@
+#pragma once
+
+#include "styled-message.h"
+
+#include <spdlog/details/log_msg.h>
+
+#include <string>
+#include <string_view>
+
+namespace warp
+{
+   // Renders a message as one JSON object with the fields from GetTag as typed
+   // JSON values, followed by a newline:
+   // {"time":"...","level":"info","message":"...","fields":{"path":"/media","count":3}}
+   class JsonRecordEncoder
+   {
+   public:
+      // Appends the record to the output. Without a parsed message there are no fields.
+      void Encode(const spdlog::details::log_msg& msg, const StyledMessage* message, spdlog::memory_buf_t& out);
+
+   private:
+      void AppendString(std::string_view text, spdlog::memory_buf_t& out);
+      void AppendValue(LogFieldType type, std::string_view value, spdlog::memory_buf_t& out);
+
+      // Reused for every string
+      std::string escaped_;
+   };
+}
\ No newline at end of file
@@ -1,10 +1,13 @@
 #pragma once
 
-#include "warp/utils.h"
+#include "notification-dispatcher.h"
+#include "warp/log/log-types.h"
 
 #include <httplib.h>
 #include <spdlog/sinks/base_sink.h>
 
+#include <format>
+#include <memory>
 #include <mutex>
 #include <string>
 
@@ -14,11 +17,29 @@ namespace warp
    class LogAppriseSink : public spdlog::sinks::base_sink<Mutex>
    {
    public:
-      explicit LogAppriseSink(const AppriseLoggingConfig& config)
+      // The setup runs on the notification worker when it starts
+      explicit LogAppriseSink(const AppriseLoggingConfig& config, std::function<void()> threadSetup = {})
          : client_(config.url)
          , key_(config.key)
          , title_(config.message_title)
+         , dispatcher_(std::make_shared<NotificationDispatcher>("apprise", config.limits, [this](const std::string& message) {
+            Send(message);
+         }, std::move(threadSetup)))
       {
+         client_.set_connection_timeout(CONNECTION_TIMEOUT_SEC);
+         client_.set_read_timeout(READ_WRITE_TIMEOUT_SEC);
+         client_.set_write_timeout(READ_WRITE_TIMEOUT_SEC);
+      }
+
+      ~LogAppriseSink() override
+      {
+         // The worker calls back into this sink, stop it before the members go away
+         dispatcher_->Stop();
+      }
+
+      [[nodiscard]] std::shared_ptr<NotificationDispatcher> GetDispatcher() const
+      {
+         return dispatcher_;
       }
 
    protected:
@@ -27,7 +48,8 @@ namespace warp
          spdlog::memory_buf_t formatted;
          spdlog::sinks::base_sink<Mutex>::formatter_->format(msg, formatted);
 
-         auto message = StripAnsiiCharacters(fmt::to_string(formatted));
+         // Messages reach this sink without styles, see StyledDistSink
+         auto message = fmt::to_string(formatted);
 
          size_t pos = 0;
          while ((pos = message.find('"', pos)) != std::string::npos)
@@ -36,11 +58,8 @@ namespace warp
             pos += 2;
          }
 
-         httplib::Params params{
-            {"title", title_},
-            {"body", message}
-         };
-         auto res = client_.Post(std::format("/notify/{}", key_), params);
+         // Sent from the dispatcher thread, never block the logging worker on the network
+         dispatcher_->Post(std::move(message));
       }
 
       void flush_() override
@@ -48,10 +67,23 @@ namespace warp
       }
 
    private:
+      static constexpr time_t CONNECTION_TIMEOUT_SEC{5};
+      static constexpr time_t READ_WRITE_TIMEOUT_SEC{10};
+
+      void Send(const std::string& message)
+      {
+         httplib::Params params{
+            {"title", title_},
+            {"body", message}
+         };
+         auto res = client_.Post(std::format("/notify/{}", key_), params);
+      }
+
       httplib::Client client_;
       std::string key_;
       std::string title_;
+      std::shared_ptr<NotificationDispatcher> dispatcher_;
    };
 
    using apprise_sink_mt = LogAppriseSink<std::mutex>;
-}
\ No newline at end of file
+}
@@ -0,0 +1,163 @@
+#include "warp/log/log-clock.h"
+
+#if WARP_LOG_HAS_TSC && !defined(_MSC_VER)
+#include <cpuid.h>
+#endif
+
+#include <algorithm>
+#include <cmath>
+#include <mutex>
+#include <thread>
+
+namespace warp
+{
+   namespace
+   {
+      constexpr auto CALIBRATION_SPIN{std::chrono::milliseconds(10)};
+      constexpr auto RECALIBRATION_INTERVAL{std::chrono::seconds(1)};
+
+      bool HasInvariantTsc()
+      {
+#if WARP_LOG_HAS_TSC && defined(_MSC_VER)
+         int info[4]{};
+         __cpuid(info, static_cast<int>(0x80000000));
+         if (static_cast<unsigned>(info[0]) < 0x80000007u) return false;
+         __cpuid(info, static_cast<int>(0x80000007));
+         return (info[3] & (1 << 8)) != 0;
+#elif WARP_LOG_HAS_TSC
+         unsigned eax{0}, ebx{0}, ecx{0}, edx{0};
+         if (!__get_cpuid(0x80000007u, &eax, &ebx, &ecx, &edx)) return false;
+         return (edx & (1u << 8)) != 0u;
+#else
+         return false;
+#endif
+      }
+
+      int64_t ReadTicks()
+      {
+#if WARP_LOG_HAS_TSC
+         return static_cast<int64_t>(__rdtsc());
+#else
+         return 0;
+#endif
+      }
+
+      int64_t SystemNanoseconds()
+      {
+         return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+      }
+
+      // Maps ticks to wall time. The rate is measured against the steady clock since
+      // the first calibration, the offset is taken from the system clock each time so
+      // adjustments of the wall clock are picked up. Readers retry while the
+      // sequence is odd or changed, writers take the lock.
+      class TscCalibration
+      {
+      public:
+         static TscCalibration& Instance()
+         {
+            static TscCalibration calibration;
+            return calibration;
+         }
+
+         void Start()
+         {
+            std::scoped_lock lock(lock_);
+            if (started_) return;
+
+            const auto before = ReadTicks();
+            startTime_ = std::chrono::steady_clock::now();
+            startTicks_ = before + (ReadTicks() - before) / 2;
+            while (std::chrono::steady_clock::now() - startTime_ < CALIBRATION_SPIN)
+            {
+               std::this_thread::yield();
+            }
+            Calibrate();
+            started_ = true;
+         }
+
+         int64_t ToNanoseconds(int64_t ticks)
+         {
+            if (ticks >= nextCalibration_.load(std::memory_order_relaxed)) Recalibrate();
+
+            while (true)
+            {
+               const auto sequence = sequence_.load(std::memory_order_acquire);
+               if ((sequence & 1u) != 0u) continue;
+
+               const auto baseTicks = baseTicks_.load(std::memory_order_relaxed);
+               const auto baseNs = baseNs_.load(std::memory_order_relaxed);
+               const auto nsPerTick = nsPerTick_.load(std::memory_order_relaxed);
+
+               std::atomic_thread_fence(std::memory_order_acquire);
+               if (sequence_.load(std::memory_order_relaxed) != sequence) continue;
+
+               return baseNs + std::llround(static_cast<double>(ticks - baseTicks) * nsPerTick);
+            }
+         }
+
+      private:
+         void Recalibrate()
+         {
+            // Whoever gets the lock refreshes it, the others convert with the current one
+            std::unique_lock lock(lock_, std::try_to_lock);
+            if (!lock.owns_lock() || !started_) return;
+            Calibrate();
+         }
+
+         void Calibrate()
+         {
+            // Ticks taken on both sides of the clock read, the midpoint matches it best
+            const auto before = ReadTicks();
+            const auto now = SystemNanoseconds();
+            const auto steady = std::chrono::steady_clock::now();
+            const auto after = ReadTicks();
+            const auto ticks = before + (after - before) / 2;
+
+            const auto elapsed = std::chrono::duration<double, std::nano>(steady - startTime_).count();
+            const auto nsPerTick = ticks > startTicks_ ? elapsed / static_cast<double>(ticks - startTicks_) : 1.0;
+            // The rate gets more exact the longer it is measured, early calibrations come sooner
+            const auto wait = std::min(elapsed, static_cast<double>(std::chrono::nanoseconds(RECALIBRATION_INTERVAL).count()));
+            const auto interval = static_cast<int64_t>(wait / nsPerTick);
+
+            sequence_.fetch_add(1u, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            baseTicks_.store(ticks, std::memory_order_relaxed);
+            baseNs_.store(now, std::memory_order_relaxed);
+            nsPerTick_.store(nsPerTick, std::memory_order_relaxed);
+            sequence_.fetch_add(1u, std::memory_order_release);
+
+            nextCalibration_.store(ticks + interval, std::memory_order_relaxed);
+         }
+
+         std::mutex lock_;
+         bool started_{false};
+         int64_t startTicks_{0};
+         std::chrono::steady_clock::time_point startTime_;
+
+         std::atomic<uint32_t> sequence_{0};
+         std::atomic<int64_t> baseTicks_{0};
+         std::atomic<int64_t> baseNs_{0};
+         std::atomic<double> nsPerTick_{1.0};
+         std::atomic<int64_t> nextCalibration_{0};
+      };
+   }
+
+   bool LogClock::SetSource(LogClockSource source)
+   {
+      if (source == LogClockSource::SYSTEM || !HasInvariantTsc())
+      {
+         tsc_ = false;
+         return source == LogClockSource::SYSTEM;
+      }
+
+      TscCalibration::Instance().Start();
+      tsc_ = true;
+      return true;
+   }
+
+   int64_t LogClock::TicksToNanoseconds(int64_t ticks)
+   {
+      return TscCalibration::Instance().ToNanoseconds(ticks);
+   }
+}
\ No newline at end of file
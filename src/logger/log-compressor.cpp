@@ -0,0 +1,175 @@
+#include "log-compressor.h"
+
+#include "file-rotation.h"
+#include "log-index.h"
+#include "log-thread.h"
+
+#include <zlib.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <format>
+#include <fstream>
+#include <string>
+#include <system_error>
+#include <vector>
+
+namespace warp
+{
+   namespace
+   {
+      constexpr std::string_view PENDING_EXTENSION{".pending"};
+      constexpr std::string_view COMPRESSED_SUFFIX{".gz"};
+
+      // Read and compressed in chunks of this size so a stop request is seen quickly
+      constexpr size_t CHUNK_SIZE{64u * 1024u};
+
+      gzFile OpenGzip(const std::filesystem::path& path, int level)
+      {
+         const auto mode = std::format("wb{}", std::clamp(level, 1, 9));
+#if defined(_WIN32)
+         return gzopen_w(path.c_str(), mode.c_str());
+#else
+         return gzopen(path.c_str(), mode.c_str());
+#endif
+      }
+
+      // Frees log.1.txt in the plain and the compressed chain. The active log.txt is still
+      // open in its sink and stays, a failed compression can have left plain files
+      // between the compressed ones.
+      void ShiftRotatedFiles(const std::filesystem::path& path, size_t maxFiles)
+      {
+         RotateLogFiles(path, maxFiles, {}, 1u);
+         RotateLogFiles(path, maxFiles, COMPRESSED_SUFFIX, 1u);
+      }
+   }
+
+   LogCompressor& LogCompressor::Instance()
+   {
+      // Never destroyed, sinks may still rotate while the logger shuts down at exit
+      static auto* instance = new LogCompressor();
+      return *instance;
+   }
+
+   void LogCompressor::Rotate(const std::filesystem::path& path, const FileLoggingConfig& config)
+   {
+      const auto now = std::chrono::system_clock::now().time_since_epoch();
+      auto pending = path;
+      pending += std::format(".{:020}{}", std::chrono::duration_cast<std::chrono::nanoseconds>(now).count(), PENDING_EXTENSION);
+
+      std::error_code ec;
+      std::filesystem::rename(path, pending, ec);
+      if (ec)
+      {
+         // Fall back to plain rotation rather than appending to a full file
+         RotateLogFiles(path, config.maxFiles);
+         return;
+      }
+      std::filesystem::rename(LogIndexPath(path), LogIndexPath(pending), ec);
+
+      {
+         std::scoped_lock lock(lock_);
+         if (seenPaths_.insert(path).second) QueueLeftovers(path, config);
+         jobs_.push_back({pending, path, config.maxFiles, config.compressionLevel});
+
+         if (!thread_)
+         {
+            thread_ = std::make_unique<std::jthread>([this](std::stop_token stopToken) {
+               Work(stopToken);
+            });
+         }
+      }
+      wakeup_.notify_one();
+   }
+
+   void LogCompressor::QueueLeftovers(const std::filesystem::path& path, const FileLoggingConfig& config)
+   {
+      const auto prefix = path.filename().string() + ".";
+
+      std::vector<std::filesystem::path> leftovers;
+      std::error_code ec;
+      for (const auto& entry : std::filesystem::directory_iterator(path.parent_path(), ec))
+      {
+         const auto name = entry.path().filename().string();
+         if (name.starts_with(prefix) && name.ends_with(PENDING_EXTENSION)) leftovers.push_back(entry.path());
+      }
+
+      // The names carry the rotation time with a fixed width
+      std::ranges::sort(leftovers);
+      for (auto& leftover : leftovers)
+      {
+         jobs_.push_back({std::move(leftover), path, config.maxFiles, config.compressionLevel});
+      }
+   }
+
+   void LogCompressor::Work(std::stop_token stopToken)
+   {
+      SetupLogThread("warp-log-gzip", {});
+      LowerLogThreadPriority();
+
+      while (!stopToken.stop_requested())
+      {
+         Job job;
+         {
+            std::unique_lock lock(lock_);
+            if (!wakeup_.wait(lock, stopToken, [this] { return !jobs_.empty(); })) break;
+
+            job = std::move(jobs_.front());
+            jobs_.pop_front();
+         }
+
+         auto temporary = RotatedLogPath(job.path, 1u, COMPRESSED_SUFFIX);
+         temporary += ".tmp";
+
+         std::error_code ec;
+         if (!Compress(job, temporary, stopToken))
+         {
+            std::filesystem::remove(temporary, ec);
+            if (stopToken.stop_requested()) break;
+
+            // Keep the data uncompressed instead of losing it
+            ShiftRotatedFiles(job.path, job.maxFiles);
+            std::filesystem::rename(job.pending, RotatedLogPath(job.path, 1u), ec);
+            std::filesystem::rename(LogIndexPath(job.pending), LogIndexPath(RotatedLogPath(job.path, 1u)), ec);
+            continue;
+         }
+
+         // Index offsets count uncompressed bytes, the reader seeks through the gzip stream
+         ShiftRotatedFiles(job.path, job.maxFiles);
+         std::filesystem::rename(temporary, RotatedLogPath(job.path, 1u, COMPRESSED_SUFFIX), ec);
+         std::filesystem::rename(LogIndexPath(job.pending), LogIndexPath(RotatedLogPath(job.path, 1u, COMPRESSED_SUFFIX)), ec);
+         std::filesystem::remove(job.pending, ec);
+      }
+   }
+
+   bool LogCompressor::Compress(const Job& job, const std::filesystem::path& target, std::stop_token stopToken)
+   {
+      std::ifstream input(job.pending, std::ios::binary);
+      if (!input) return false;
+
+      gzFile output = OpenGzip(target, job.level);
+      if (output == nullptr) return false;
+
+      std::vector<char> buffer(CHUNK_SIZE);
+      bool success{true};
+      while (success && input)
+      {
+         if (stopToken.stop_requested())
+         {
+            success = false;
+            break;
+         }
+
+         input.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+         const auto count = static_cast<unsigned>(input.gcount());
+         if (count > 0u && gzwrite(output, buffer.data(), count) != static_cast<int>(count))
+         {
+            success = false;
+         }
+      }
+
+      if (input.bad()) success = false;
+      return gzclose(output) == Z_OK && success;
+   }
+}
\ No newline at end of file
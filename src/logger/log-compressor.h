@@ -0,0 +1,54 @@
+#pragma once
+
+#include "warp/log/log-types.h"
+
+#include <condition_variable>
+#include <deque>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <thread>
+
+namespace warp
+{
+   // Compresses rotated log files with gzip on a low priority thread shared by all
+   // file sinks. A rotated file is renamed to log.txt.<time>.pending right away, the
+   // thread compresses it and then shifts log.1.txt.gz -> log.2.txt.gz -> ... to make
+   // room for it, so the logging worker only pays for the rename. Pending files left
+   // behind by an earlier run, or by a run that exited mid compression, are picked
+   // up with the next rotation of the same log.
+   class LogCompressor
+   {
+   public:
+      static LogCompressor& Instance();
+
+      // Moves the closed log file aside and queues it for compression
+      void Rotate(const std::filesystem::path& path, const FileLoggingConfig& config);
+
+   private:
+      struct Job
+      {
+         std::filesystem::path pending;
+         std::filesystem::path path;
+         size_t maxFiles{0};
+         int level{0};
+      };
+
+      LogCompressor() = default;
+
+      void Work(std::stop_token stopToken);
+
+      // Queues the pending files of earlier runs, oldest first
+      void QueueLeftovers(const std::filesystem::path& path, const FileLoggingConfig& config);
+
+      // Returns false if the file could not be compressed or the thread is stopping
+      static bool Compress(const Job& job, const std::filesystem::path& target, std::stop_token stopToken);
+
+      std::mutex lock_;
+      std::condition_variable_any wakeup_;
+      std::deque<Job> jobs_;
+      std::set<std::filesystem::path> seenPaths_;
+      std::unique_ptr<std::jthread> thread_;
+   };
+}
\ No newline at end of file
@@ -1,10 +1,13 @@
 #pragma once
 
-#include "warp/utils.h"
+#include "notification-dispatcher.h"
+#include "warp/log/log-types.h"
 
 #include <httplib.h>
 #include <spdlog/sinks/base_sink.h>
 
+#include <format>
+#include <memory>
 #include <mutex>
 #include <string>
 
@@ -14,12 +17,30 @@ namespace warp
    class LogGotifySink : public spdlog::sinks::base_sink<Mutex>
    {
    public:
-      explicit LogGotifySink(const GotifyLoggingConfig& config)
+      // The setup runs on the notification worker when it starts
+      explicit LogGotifySink(const GotifyLoggingConfig& config, std::function<void()> threadSetup = {})
          : client_(config.url)
          , title_(config.message_title)
          , priority_{config.priority}
          , headers_{{"X-Gotify-Key", config.key}}
+         , dispatcher_(std::make_shared<NotificationDispatcher>("gotify", config.limits, [this](const std::string& message) {
+            Send(message);
+         }, std::move(threadSetup)))
       {
+         client_.set_connection_timeout(CONNECTION_TIMEOUT_SEC);
+         client_.set_read_timeout(READ_WRITE_TIMEOUT_SEC);
+         client_.set_write_timeout(READ_WRITE_TIMEOUT_SEC);
+      }
+
+      ~LogGotifySink() override
+      {
+         // The worker calls back into this sink, stop it before the members go away
+         dispatcher_->Stop();
+      }
+
+      [[nodiscard]] std::shared_ptr<NotificationDispatcher> GetDispatcher() const
+      {
+         return dispatcher_;
       }
 
    protected:
@@ -28,7 +49,8 @@ namespace warp
          spdlog::memory_buf_t formatted;
          spdlog::sinks::base_sink<Mutex>::formatter_->format(msg, formatted);
 
-         auto message = StripAnsiiCharacters(fmt::to_string(formatted));
+         // Messages reach this sink without styles, see StyledDistSink
+         auto message = fmt::to_string(formatted);
 
          size_t pos = 0u;
          while ((pos = message.find('"', pos)) != std::string::npos)
@@ -37,6 +59,20 @@ namespace warp
             pos += 2;
          }
 
+         // Sent from the dispatcher thread, never block the logging worker on the network
+         dispatcher_->Post(std::move(message));
+      }
+
+      void flush_() override
+      {
+      }
+
+   private:
+      static constexpr time_t CONNECTION_TIMEOUT_SEC{5};
+      static constexpr time_t READ_WRITE_TIMEOUT_SEC{10};
+
+      void Send(const std::string& message)
+      {
          httplib::Params params{
             {"title", title_},
             {"message", message},
@@ -45,16 +81,12 @@ namespace warp
          auto res = client_.Post("/message", headers_, params);
       }
 
-      void flush_() override
-      {
-      }
-
-   private:
       httplib::Client client_;
       std::string title_;
       int32_t priority_{0};
       httplib::Headers headers_;
+      std::shared_ptr<NotificationDispatcher> dispatcher_;
    };
 
    using gotify_sink_mt = LogGotifySink<std::mutex>;
-}
\ No newline at end of file
+}
@@ -0,0 +1,471 @@
+#include "log-index.h"
+
+#include "file-rotation.h"
+
+#include <zlib.h>
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <ctime>
+#include <limits>
+#include <optional>
+#include <string>
+#include <system_error>
+
+namespace warp
+{
+   namespace
+   {
+      constexpr size_t INDEX_HEADER_SIZE{LOG_INDEX_MAGIC.size() + 1u};
+
+      // Lines are written in queue order, their times can run slightly behind
+      constexpr int64_t SLACK_SECONDS{1};
+
+      constexpr size_t READ_CHUNK_SIZE{64u * 1024u};
+      constexpr uint64_t END_OF_FILE{std::numeric_limits<uint64_t>::max()};
+
+      // MM/DD/YYYY HH:MM:SS as written by LineFormatter
+      constexpr size_t TIMESTAMP_LENGTH{19u};
+
+      constexpr std::string_view PENDING_EXTENSION{".pending"};
+      constexpr std::string_view COMPRESSED_SUFFIX{".gz"};
+
+      struct ByteRange
+      {
+         uint64_t begin{0};
+         uint64_t end{END_OF_FILE};
+      };
+
+      LogType ToLogType(spdlog::level::level_enum level)
+      {
+         switch (level)
+         {
+            case spdlog::level::trace:
+            case spdlog::level::debug:
+               return LogType::TRACE;
+            case spdlog::level::warn:
+               return LogType::WARN;
+            case spdlog::level::err:
+               return LogType::ERR;
+            case spdlog::level::critical:
+               return LogType::CRITICAL;
+            default:
+               return LogType::INFO;
+         }
+      }
+
+      std::optional<LogType> ParseLevel(std::string_view name)
+      {
+         for (int level = spdlog::level::trace; level < spdlog::level::off; ++level)
+         {
+            const auto levelName = spdlog::level::to_string_view(static_cast<spdlog::level::level_enum>(level));
+            if (name == std::string_view(levelName.data(), levelName.size()))
+            {
+               return ToLogType(static_cast<spdlog::level::level_enum>(level));
+            }
+         }
+         return std::nullopt;
+      }
+
+      std::FILE* OpenFile(const std::filesystem::path& path, const char* mode)
+      {
+#if defined(_WIN32)
+         const std::wstring wideMode(mode, mode + std::strlen(mode));
+         return _wfopen(path.c_str(), wideMode.c_str());
+#else
+         return std::fopen(path.c_str(), mode);
+#endif
+      }
+
+      gzFile OpenSegment(const std::filesystem::path& path)
+      {
+         // zlib reads uncompressed files as they are and seeks in them directly
+#if defined(_WIN32)
+         return gzopen_w(path.c_str(), "rb");
+#else
+         return gzopen(path.c_str(), "rb");
+#endif
+      }
+
+      bool ReadIndexHeader(std::FILE* file)
+      {
+         std::array<char, INDEX_HEADER_SIZE> header{};
+         if (std::fread(header.data(), 1u, header.size(), file) != header.size()) return false;
+         return std::string_view(header.data(), LOG_INDEX_MAGIC.size()) == LOG_INDEX_MAGIC
+                && static_cast<uint8_t>(header.back()) == LOG_INDEX_VERSION;
+      }
+
+      std::vector<LogIndexEntry> ReadIndex(const std::filesystem::path& path)
+      {
+         std::vector<LogIndexEntry> entries;
+         auto* file = OpenFile(path, "rb");
+         if (file == nullptr) return entries;
+
+         if (ReadIndexHeader(file))
+         {
+            LogIndexEntry entry;
+            while (std::fread(&entry, sizeof(entry), 1u, file) == 1u)
+            {
+               entries.push_back(entry);
+            }
+         }
+         std::fclose(file);
+         return entries;
+      }
+
+      bool HasCounts(const LogIndexEntry& entry)
+      {
+         return std::ranges::any_of(entry.counts, [](uint32_t count) { return count > 0u; });
+      }
+
+      // Returns the parts of a file that can hold records the query wants. A file without
+      // an index is read whole.
+      std::vector<ByteRange> GetRanges(const std::vector<LogIndexEntry>& entries, const LogQuery& query, int64_t from, int64_t to)
+      {
+         if (entries.empty()) return {ByteRange{}};
+
+         std::vector<ByteRange> ranges;
+         const auto add = [&ranges](uint64_t begin, uint64_t end) {
+            if (!ranges.empty() && ranges.back().end == begin) ranges.back().end = end;
+            else ranges.push_back({begin, end});
+         };
+
+         // Lines written before the index existed
+         if (entries.front().offset > 0u) add(0u, entries.front().offset);
+
+         const auto minLevel = static_cast<size_t>(query.minLevel);
+         for (size_t i = 0; i < entries.size(); ++i)
+         {
+            const auto& entry = entries[i];
+            const auto end = i + 1u < entries.size() ? entries[i + 1u].offset : END_OF_FILE;
+
+            if (HasCounts(entry))
+            {
+               if (entry.second < from - SLACK_SECONDS || entry.second > to + SLACK_SECONDS) continue;
+
+               uint32_t wanted{0};
+               for (size_t level = minLevel; level < entry.counts.size(); ++level) wanted += entry.counts[level];
+               if (wanted == 0u) continue;
+            }
+            add(entry.offset, end);
+         }
+         return ranges;
+      }
+
+      // Splits lines into records and keeps the ones the query asks for
+      class RecordParser
+      {
+      public:
+         RecordParser(const LogQuery& query, int64_t from, int64_t to, std::vector<LogRecord>& records)
+            : query_(query)
+            , from_(from)
+            , to_(to)
+            , records_(records)
+         {
+         }
+
+         void Line(std::string_view line)
+         {
+            if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+
+            int64_t second{0};
+            LogType level{LogType::INFO};
+            std::string_view message;
+            if (!ParseStart(line, second, level, message))
+            {
+               // Further lines of a multi line message
+               if (keep_)
+               {
+                  records_.back().message.push_back('\n');
+                  records_.back().message.append(line);
+               }
+               return;
+            }
+
+            keep_ = second >= from_ && second <= to_ && level >= query_.minLevel;
+            if (keep_)
+            {
+               records_.push_back({std::chrono::system_clock::from_time_t(static_cast<std::time_t>(second)), level, std::string(message)});
+            }
+         }
+
+         // Ends the record at the end of a range, the next range starts with a new one
+         void Finish()
+         {
+            keep_ = false;
+         }
+
+      private:
+         bool ParseStart(std::string_view line, int64_t& second, LogType& level, std::string_view& message)
+         {
+            if (line.size() < TIMESTAMP_LENGTH + 4u || line.compare(TIMESTAMP_LENGTH, 2u, " [") != 0) return false;
+
+            const auto levelEnd = line.find("] ", TIMESTAMP_LENGTH + 2u);
+            if (levelEnd == std::string_view::npos) return false;
+
+            const auto parsedLevel = ParseLevel(line.substr(TIMESTAMP_LENGTH + 2u, levelEnd - TIMESTAMP_LENGTH - 2u));
+            if (!parsedLevel || !ParseTime(line.substr(0, TIMESTAMP_LENGTH), second)) return false;
+
+            level = *parsedLevel;
+            message = line.substr(levelEnd + 2u);
+            return true;
+         }
+
+         bool ParseTime(std::string_view text, int64_t& second)
+         {
+            // Consecutive lines mostly share their second
+            if (text == std::string_view(lastTimestamp_.data(), lastTimestamp_.size()))
+            {
+               second = lastSecond_;
+               return true;
+            }
+
+            constexpr std::array<size_t, 5> separators{2u, 5u, 10u, 13u, 16u};
+            constexpr std::string_view separatorChars{"// ::"};
+            for (size_t i = 0; i < text.size(); ++i)
+            {
+               const auto separator = std::ranges::find(separators, i);
+               if (separator != separators.end())
+               {
+                  if (text[i] != separatorChars[static_cast<size_t>(separator - separators.begin())]) return false;
+               }
+               else if (text[i] < '0' || text[i] > '9')
+               {
+                  return false;
+               }
+            }
+
+            const auto number = [text](size_t pos, size_t length) {
+               int value{0};
+               for (size_t i = pos; i < pos + length; ++i) value = value * 10 + (text[i] - '0');
+               return value;
+            };
+
+            // The file holds local time
+            std::tm tm{};
+            tm.tm_mon = number(0u, 2u) - 1;
+            tm.tm_mday = number(3u, 2u);
+            tm.tm_year = number(6u, 4u) - 1900;
+            tm.tm_hour = number(11u, 2u);
+            tm.tm_min = number(14u, 2u);
+            tm.tm_sec = number(17u, 2u);
+            tm.tm_isdst = -1;
+
+            const auto time = std::mktime(&tm);
+            if (time == static_cast<std::time_t>(-1)) return false;
+
+            std::ranges::copy(text, lastTimestamp_.begin());
+            lastSecond_ = static_cast<int64_t>(time);
+            second = lastSecond_;
+            return true;
+         }
+
+         const LogQuery& query_;
+         int64_t from_;
+         int64_t to_;
+         std::vector<LogRecord>& records_;
+         bool keep_{false};
+
+         std::array<char, TIMESTAMP_LENGTH> lastTimestamp_{};
+         int64_t lastSecond_{0};
+      };
+
+      void ReadRanges(const std::filesystem::path& path, const std::vector<ByteRange>& ranges, RecordParser& parser)
+      {
+         gzFile file = OpenSegment(path);
+         if (file == nullptr) return;
+
+         std::vector<char> buffer(READ_CHUNK_SIZE);
+         std::string partial;
+         for (const auto& range : ranges)
+         {
+            if (gzseek(file, static_cast<z_off_t>(range.begin), SEEK_SET) < 0) break;
+
+            uint64_t position = range.begin;
+            bool ended{false};
+            partial.clear();
+            while (!ended && position < range.end)
+            {
+               const auto wanted = static_cast<unsigned>(std::min<uint64_t>(buffer.size(), range.end - position));
+               const int count = gzread(file, buffer.data(), wanted);
+               if (count <= 0) break;
+               position += static_cast<uint64_t>(count);
+
+               std::string_view data(buffer.data(), static_cast<size_t>(count));
+
+               // The zero filled tail of a file that was not closed cleanly
+               if (const auto zero = data.find('\0'); zero != std::string_view::npos)
+               {
+                  data = data.substr(0, zero);
+                  ended = true;
+               }
+
+               size_t start{0};
+               for (auto newline = data.find('\n'); newline != std::string_view::npos; newline = data.find('\n', start))
+               {
+                  if (partial.empty())
+                  {
+                     parser.Line(data.substr(start, newline - start));
+                  }
+                  else
+                  {
+                     partial.append(data.substr(start, newline - start));
+                     parser.Line(partial);
+                     partial.clear();
+                  }
+                  start = newline + 1u;
+               }
+               partial.append(data.substr(start));
+            }
+
+            if (!partial.empty()) parser.Line(partial);
+            parser.Finish();
+         }
+         gzclose(file);
+      }
+
+      // Returns the files of the log, oldest first as far as their names tell
+      std::vector<std::filesystem::path> GetLogFiles(const std::filesystem::path& path)
+      {
+         std::vector<std::filesystem::path> files;
+         std::error_code ec;
+
+         // Compressed and plain files mix when compression was turned on or failed
+         const auto exists = [&path, &ec](size_t index, std::string_view suffix) {
+            return std::filesystem::exists(RotatedLogPath(path, index, suffix), ec);
+         };
+         size_t count{0};
+         while (exists(count + 1u, COMPRESSED_SUFFIX) || exists(count + 1u, {})) ++count;
+         for (auto i = count; i > 0u; --i)
+         {
+            for (const auto suffix : {COMPRESSED_SUFFIX, std::string_view{}})
+            {
+               if (exists(i, suffix)) files.push_back(RotatedLogPath(path, i, suffix));
+            }
+         }
+
+         // Rotated files still waiting for the compressor, named after their rotation time
+         const auto prefix = path.filename().string() + ".";
+         std::vector<std::filesystem::path> pending;
+         for (const auto& entry : std::filesystem::directory_iterator(path.parent_path(), ec))
+         {
+            const auto name = entry.path().filename().string();
+            if (name.starts_with(prefix) && name.ends_with(PENDING_EXTENSION)) pending.push_back(entry.path());
+         }
+         std::ranges::sort(pending);
+         files.insert(files.end(), pending.begin(), pending.end());
+
+         if (std::filesystem::exists(path, ec)) files.push_back(path);
+         return files;
+      }
+   }
+
+   std::filesystem::path LogIndexPath(const std::filesystem::path& file)
+   {
+      auto path = file;
+      path += LOG_INDEX_SUFFIX;
+      return path;
+   }
+
+   LogIndexWriter::~LogIndexWriter()
+   {
+      Close();
+   }
+
+   void LogIndexWriter::Open(const std::filesystem::path& file, uint64_t fileSize)
+   {
+      Close();
+
+      const auto path = LogIndexPath(file);
+      auto entries = ReadIndex(path);
+      std::erase_if(entries, [fileSize](const LogIndexEntry& entry) { return entry.offset >= fileSize; });
+
+      // Rewritten whole, it only holds an entry per second of the file
+      file_ = OpenFile(path, "w+b");
+      if (file_ == nullptr) return;
+
+      std::array<char, INDEX_HEADER_SIZE> header{};
+      std::ranges::copy(LOG_INDEX_MAGIC, header.begin());
+      header.back() = static_cast<char>(LOG_INDEX_VERSION);
+      std::fwrite(header.data(), 1u, header.size(), file_);
+
+      // Lines after the last entry may be from any later second
+      if (!entries.empty()) entries.back().counts = {};
+      if (!entries.empty()) std::fwrite(entries.data(), sizeof(LogIndexEntry), entries.size(), file_);
+      std::fflush(file_);
+
+      currentPosition_ = -1;
+      dirty_ = false;
+   }
+
+   void LogIndexWriter::Close()
+   {
+      if (file_ == nullptr) return;
+
+      Flush();
+      std::fclose(file_);
+      file_ = nullptr;
+      currentPosition_ = -1;
+   }
+
+   void LogIndexWriter::Add(int64_t second, spdlog::level::level_enum level, uint64_t offset)
+   {
+      if (file_ == nullptr) return;
+
+      // A line stamped before the current second stays in it, seconds only move forward
+      bool added{false};
+      if (currentPosition_ < 0 || second > current_.second)
+      {
+         if (dirty_) WriteCurrent();
+
+         std::fseek(file_, 0, SEEK_END);
+         currentPosition_ = std::ftell(file_);
+         current_ = {second, offset, {}};
+         added = true;
+      }
+
+      ++current_.counts[static_cast<size_t>(ToLogType(level))];
+      dirty_ = true;
+
+      // A new entry goes out right away so its offset is known before the counts are final
+      if (added) WriteCurrent();
+   }
+
+   void LogIndexWriter::Flush()
+   {
+      if (file_ == nullptr) return;
+
+      if (dirty_) WriteCurrent();
+      std::fflush(file_);
+   }
+
+   void LogIndexWriter::WriteCurrent()
+   {
+      std::fseek(file_, currentPosition_, SEEK_SET);
+      std::fwrite(&current_, sizeof(current_), 1u, file_);
+      dirty_ = false;
+   }
+
+   std::vector<LogRecord> QueryLogFiles(const std::filesystem::path& path, const LogQuery& query)
+   {
+      const auto toSecond = [](std::chrono::system_clock::time_point time) {
+         return static_cast<int64_t>(std::chrono::floor<std::chrono::seconds>(time.time_since_epoch()).count());
+      };
+      const int64_t from = query.from ? toSecond(*query.from) : std::numeric_limits<int64_t>::min() + SLACK_SECONDS;
+      const int64_t to = query.to ? toSecond(*query.to) : std::numeric_limits<int64_t>::max() - SLACK_SECONDS;
+
+      std::vector<LogRecord> records;
+      RecordParser parser(query, from, to, records);
+      for (const auto& file : GetLogFiles(path))
+      {
+         const auto ranges = GetRanges(ReadIndex(LogIndexPath(file)), query, from, to);
+         if (!ranges.empty()) ReadRanges(file, ranges, parser);
+      }
+
+      // The files are only roughly in order, lines within a file slightly out of it
+      std::ranges::stable_sort(records, {}, &LogRecord::time);
+      if (query.limit > 0u && records.size() > query.limit) records.resize(query.limit);
+      return records;
+   }
+}
\ No newline at end of file
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "warp/log/log-types.h"
+
+#include <spdlog/common.h>
+
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <string_view>
+#include <vector>
+
+namespace warp
+{
+   // Sidecar index of a text log file, log.txt.idx next to log.txt. It holds an entry
+   // per second of log time with the offset of the first line of that second and the
+   // lines per level, so a query seeks to the seconds it wants and skips the rest.
+   //
+   // The file starts with LOG_INDEX_MAGIC and LOG_INDEX_VERSION followed by entries in
+   // host byte order. The entry of the current second is rewritten as its counts grow.
+   // An entry without counts is one whose lines are not known, for example after a crash.
+   inline constexpr std::string_view LOG_INDEX_MAGIC{"WIDX"};
+   inline constexpr uint8_t LOG_INDEX_VERSION{1};
+   inline constexpr std::string_view LOG_INDEX_SUFFIX{".idx"};
+   inline constexpr size_t LOG_INDEX_LEVELS{static_cast<size_t>(LogType::CRITICAL) + 1u};
+
+   struct LogIndexEntry
+   {
+      int64_t second{0};
+      uint64_t offset{0};
+      std::array<uint32_t, LOG_INDEX_LEVELS> counts{};
+   };
+
+   // Returns log.txt.idx for log.txt, log.1.txt.gz.idx for log.1.txt.gz
+   std::filesystem::path LogIndexPath(const std::filesystem::path& file);
+
+   // Keeps the index of the file a MappedFileSink writes
+   class LogIndexWriter
+   {
+   public:
+      ~LogIndexWriter();
+
+      // Opens or creates the index. Entries at or past the file size are dropped, their
+      // lines were lost in a crash. The counts of the last entry are no longer trusted.
+      void Open(const std::filesystem::path& file, uint64_t fileSize);
+      void Close();
+
+      // Counts a line of the level that starts at the offset
+      void Add(int64_t second, spdlog::level::level_enum level, uint64_t offset);
+
+      // Writes the counts of the current second
+      void Flush();
+
+   private:
+      void WriteCurrent();
+
+      std::FILE* file_{nullptr};
+      long currentPosition_{-1};
+      LogIndexEntry current_;
+      bool dirty_{false};
+   };
+
+   // Reads the records of a text log and its rotated files, compressed ones included.
+   // Files and seconds the index rules out are not read.
+   std::vector<LogRecord> QueryLogFiles(const std::filesystem::path& path, const LogQuery& query);
+}
\ No newline at end of file
@@ -0,0 +1,81 @@
+#include "log-thread.h"
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <sys/resource.h>
+#if defined(__linux__)
+#include <sched.h>
+#include <unistd.h>
+#endif
+#endif
+
+namespace warp
+{
+#if defined(_WIN32)
+   void SetupLogThread(const std::string& name, const std::vector<uint32_t>& cpus)
+   {
+      if (!name.empty())
+      {
+         const std::wstring wideName(name.begin(), name.end());
+         SetThreadDescription(GetCurrentThread(), wideName.c_str());
+      }
+
+      // Only the first processor group can be expressed in an affinity mask
+      DWORD_PTR mask{0};
+      for (const auto cpu : cpus)
+      {
+         if (cpu < sizeof(DWORD_PTR) * 8u) mask |= DWORD_PTR{1} << cpu;
+      }
+      if (mask != 0) SetThreadAffinityMask(GetCurrentThread(), mask);
+   }
+
+   void LowerLogThreadPriority()
+   {
+      SetThreadPriority(GetCurrentThread(), THREAD_MODE_BACKGROUND_BEGIN);
+   }
+#else
+   void SetupLogThread(const std::string& name, const std::vector<uint32_t>& cpus)
+   {
+      if (!name.empty())
+      {
+#if defined(__APPLE__)
+         pthread_setname_np(name.c_str());
+#else
+         // Longer names are rejected, not truncated
+         constexpr size_t MAX_NAME_LENGTH{15u};
+         pthread_setname_np(pthread_self(), name.substr(0, MAX_NAME_LENGTH).c_str());
+#endif
+      }
+
+#if defined(__linux__)
+      if (cpus.empty()) return;
+
+      cpu_set_t set;
+      CPU_ZERO(&set);
+      for (const auto cpu : cpus)
+      {
+         if (cpu < CPU_SETSIZE) CPU_SET(cpu, &set);
+      }
+      pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#endif
+   }
+
+   void LowerLogThreadPriority()
+   {
+#if defined(__linux__)
+      // Linux applies the nice value per thread
+      setpriority(PRIO_PROCESS, static_cast<id_t>(gettid()), 19);
+#elif defined(__APPLE__)
+      setpriority(PRIO_DARWIN_THREAD, 0, PRIO_DARWIN_BG);
+#endif
+   }
+#endif
+}
\ No newline at end of file
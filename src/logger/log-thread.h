@@ -0,0 +1,15 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace warp
+{
+   // Names the calling thread and pins it to the CPUs, if any are given. Failures are
+   // ignored, the thread keeps running with its defaults.
+   void SetupLogThread(const std::string& name, const std::vector<uint32_t>& cpus);
+
+   // Runs the calling thread below normal priority, for background work such as compression
+   void LowerLogThreadPriority();
+}
\ No newline at end of file
@@ -1,17 +1,40 @@
 #include "warp/log/logger.h"
 
 #include "ansii-formatter.h"
-#include "ansii-remove-formatter.h"
+#include "binary-file-sink.h"
+#include "console-sink.h"
+#include "datagram-sink.h"
+#include "deferred-backend.h"
+#include "json-lines-sink.h"
+#include "internal-types.h"
+#include "log-thread.h"
 #include "log-apprise-sync.h"
 #include "log-gotify-sync.h"
+#include "log-index.h"
+#include "mapped-file-sink.h"
+#include "notification-dispatcher.h"
+#include "styled-dist-sink.h"
+#include "worker-queue.h"
 
 #include <spdlog/async.h>
 #include <spdlog/async_logger.h>
-#include <spdlog/sinks/rotating_file_sink.h>
-#include <spdlog/sinks/stdout_color_sinks.h>
 
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <deque>
 #include <filesystem>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
 #include <string>
+#include <thread>
+#include <utility>
+#include <vector>
 
 namespace warp
 {
@@ -33,82 +56,590 @@ namespace warp
                return spdlog::level::info;
          }
       }
+
+      spdlog::async_overflow_policy ToSpdLogPolicy(LogOverflowPolicy policy)
+      {
+         switch (policy)
+         {
+            case LogOverflowPolicy::OVERRUN_OLDEST:
+               return spdlog::async_overflow_policy::overrun_oldest;
+            case LogOverflowPolicy::DISCARD:
+               return spdlog::async_overflow_policy::discard_new;
+            default:
+               return spdlog::async_overflow_policy::block;
+         }
+      }
+
+      constexpr size_t LOG_TYPE_COUNT{static_cast<size_t>(LogType::CRITICAL) + 1u};
+      constexpr size_t POLICY_COUNT{static_cast<size_t>(LogOverflowPolicy::DISCARD) + 1u};
+
+      // Writers only look at the queue depth every so many messages
+      constexpr uint32_t DEPTH_SAMPLE_INTERVAL{16u};
+
+      // Call sites sharing a slot take it over from each other, reporting the pending summary
+      constexpr size_t SUPPRESSION_SLOT_BITS{10u};
+      constexpr size_t SUPPRESSION_SLOTS{size_t{1u} << SUPPRESSION_SLOT_BITS};
+
+      struct SuppressionSlot
+      {
+         std::atomic<uintptr_t> site{0};
+         std::atomic<int64_t> windowStart{0};
+         std::atomic<uint32_t> count{0};
+
+         // Described by the first call a window suppressed, for its summary
+         std::mutex summaryLock;
+         uintptr_t summarySite{0};
+         LogType summaryLevel{LogType::INFO};
+         std::string summary;
+      };
+
+      // Returns the message reporting the calls of a site that were suppressed
+      std::string TakeSuppressionSummary(SuppressionSlot& slot, uintptr_t site, uint32_t repeats, LogType& level)
+      {
+         std::scoped_lock lock(slot.summaryLock);
+         if (slot.summarySite != site) return std::format("A call site repeated {} times", repeats);
+
+         level = slot.summaryLevel;
+         slot.summarySite = 0;
+         return std::format("{} repeated {} times", std::exchange(slot.summary, {}), repeats);
+      }
+
+      struct Component
+      {
+         explicit Component(std::string_view componentName)
+            : name(componentName)
+         {
+         }
+
+         std::string name;
+         Logger::ComponentLevel level{Logger::COMPONENT_LEVEL_GLOBAL};
+      };
+
+      // Trace in debug builds or with WARP_LOG_TRACE set, info otherwise
+      LogType DefaultLevel()
+      {
+#if defined(_DEBUG) || !defined(NDEBUG)
+         return LogType::TRACE;
+#else
+         return std::getenv("WARP_LOG_TRACE") ? LogType::TRACE : LogType::INFO;
+#endif
+      }
+
+      // Returns false for names that are not a level. "default" follows the global level.
+      bool ParseComponentLevel(std::string_view name, std::optional<LogType>& level)
+      {
+         if (name == "trace") level = LogType::TRACE;
+         else if (name == "info") level = LogType::INFO;
+         else if (name == "warn" || name == "warning") level = LogType::WARN;
+         else if (name == "err" || name == "error") level = LogType::ERR;
+         else if (name == "critical") level = LogType::CRITICAL;
+         else if (name == "default") level = std::nullopt;
+         else return false;
+         return true;
+      }
+
+      std::string_view Trim(std::string_view text)
+      {
+         const auto start = text.find_first_not_of(" \t");
+         if (start == std::string_view::npos) return {};
+         return text.substr(start, text.find_last_not_of(" \t") - start + 1u);
+      }
+
+      spdlog::log_clock::time_point ToLogTime(int64_t ns)
+      {
+         return spdlog::log_clock::time_point(
+            std::chrono::duration_cast<spdlog::log_clock::duration>(std::chrono::nanoseconds(ns)));
+      }
+
+      // Recreated by its thread when the backtrace size changes
+      thread_local std::unique_ptr<DeferredRing> backtraceRing;
+
+      // Scratch space of Logger::QueueRecord, each record is released once queued
+      constexpr size_t RECORD_RING_SIZE{64u * 1024u};
+      thread_local std::unique_ptr<DeferredRing> recordRing;
+
+      // Settings of Configure, taken over by the constructor when Configure creates the logger
+      std::optional<LogConfig>& PendingConfig()
+      {
+         static std::optional<LogConfig> config;
+         return config;
+      }
+
+      // Guards PendingConfig between Configure and the constructor on another thread
+      std::mutex& PendingConfigLock()
+      {
+         static std::mutex lock;
+         return lock;
+      }
+
+      // Keeps a worker that missed the shutdown deadline alive until the process exits,
+      // along with what it writes to. Never freed, destroying it would join the worker.
+      void Abandon(std::shared_ptr<void> object)
+      {
+         static std::mutex lock;
+         static auto* abandoned = new std::vector<std::shared_ptr<void>>();
+
+         std::scoped_lock guard(lock);
+         abandoned->push_back(std::move(object));
+      }
+
+      struct NotificationSink
+      {
+         spdlog::sink_ptr sink;
+         std::shared_ptr<NotificationDispatcher> dispatcher;
+      };
+
+      size_t GetSuppressionSlot(uintptr_t site)
+      {
+         // Format strings are aligned, mix the bits before taking the top ones
+         return static_cast<size_t>((static_cast<uint64_t>(site) * 0x9E3779B97F4A7C15ull) >> (64u - SUPPRESSION_SLOT_BITS));
+      }
    }
 
    struct Logger::Impl
    {
-      std::shared_ptr<spdlog::logger> logger_;
+      // The loggers of one queue. Replaced as a whole, a writer keeps the set it took alive.
+      struct LoggerSet
+      {
+         // Empty once shut down, the loggers then write on the calling thread
+         std::shared_ptr<spdlog::details::thread_pool> threadPool;
+         // One logger per policy, all writing to the styled sink through the same pool
+         std::array<std::shared_ptr<spdlog::logger>, POLICY_COUNT> policyLoggers;
+         std::array<std::shared_ptr<spdlog::logger>, LOG_TYPE_COUNT> levelLoggers;
+         std::array<LogOverflowPolicy, LOG_TYPE_COUNT> levelPolicies{};
+         size_t queueSize{0};
+         // Depth seen by the last sample, read by writers instead of locking the queue
+         std::atomic<size_t> lastDepth{0};
+      };
+
+      // Builds a new thread pool with one async logger per overflow policy in use
+      std::shared_ptr<LoggerSet> CreateLoggers(const LogQueueConfig& config);
+
+      // A single synchronous logger for every level, used after Shutdown
+      std::shared_ptr<LoggerSet> CreateSyncLoggers();
+
+      // Swaps in the loggers of the config and moves the sinks onto their workers.
+      // The old pool writes what it has queued before it exits.
+      void StartQueue(const LogQueueConfig& config);
+
+      // Publishes the loggers and returns the ones replaced
+      std::shared_ptr<LoggerSet> SwapLoggers(std::shared_ptr<LoggerSet> loggers);
+
+      std::shared_ptr<LoggerSet> GetLoggers() const;
+      std::shared_ptr<spdlog::logger> GetLogger(LogType level) const;
+
+      void Write(LogType level, spdlog::log_clock::time_point time, std::string_view msg, const spdlog::source_loc& source = {});
+
+      // Queues the record unformatted, see DEFERRED_RECORD_SOURCE
+      void WriteRecord(const DeferredRecord& record);
+
+      // Returns the current queue depth and raises the high-water mark
+      size_t SampleDepth(LoggerSet& loggers);
+
+      // Waits until the workers took every queued message. Returns false at the deadline.
+      static bool DrainQueue(const LoggerSet& loggers, std::chrono::steady_clock::time_point deadline);
+
+      // Removes every sink, for a configuration that replaces them
+      void ClearSinks();
+
+      // Stops the notification workers. A worker still sending at the deadline is left
+      // behind with its sink, which its sender calls into.
+      void StopNotifications(std::chrono::steady_clock::time_point deadline);
+
+      // Returns the setup run by a logging thread, named after the configured name and the suffix
+      std::function<void()> GetThreadSetup(std::string suffix);
+
+      // Creates the directory of the file and adds the sink. Failures are logged as warnings.
+      template <typename CreateSink>
+      void AddFileSink(const std::filesystem::path& p, std::string_view description, SinkOutput output, CreateSink&& create);
+
+      // Returns the component, creating it on first use
+      Component& FindComponent(std::string_view name);
+
+      void StartFlusher(std::chrono::milliseconds interval);
+      void StopFlusher();
+
+      // Writers copy the set under a shared lock and log without holding it
+      mutable std::shared_mutex loggersLock_;
+      std::shared_ptr<LoggerSet> loggers_;
+
+      // Serializes Apply, ConfigureQueue and Shutdown
+      std::mutex configureLock_;
+      bool shutDown_{false};
+
+      LogFlushPolicy flushPolicy_;
+      std::string threadName_;
+      std::vector<uint32_t> cpuAffinity_;
+
+      std::shared_ptr<StyledDistSink> styledSink_;
+      spdlog::sink_ptr consoleSink_;
+      std::unique_ptr<DeferredBackend> deferred_;
+      std::vector<NotificationSink> notifications_;
+      std::vector<std::shared_ptr<DatagramSink>> datagrams_;
+
+      // Flushes the styled sink on the flush interval. The sink skips the flush if nothing was written.
+      std::mutex flushLock_;
+      std::condition_variable_any flushWakeup_;
+      std::unique_ptr<std::jthread> flusher_;
+
+      std::atomic<size_t> highWaterMark_{0};
+      std::atomic<uint32_t> sampleCounter_{0};
+      std::atomic<uint64_t> blockedNs_{0};
+
+      // Entries never move, Base objects keep a pointer to their level
+      std::mutex componentsLock_;
+      std::deque<Component> components_;
+
+      std::array<SuppressionSlot, SUPPRESSION_SLOTS> suppression_;
+
+      // Reports the windows that ended with suppressed calls, so a burst that stopped
+      // is reported without waiting for its call site to log again
+      void FlushSuppression();
+      std::atomic<uint32_t> suppressionBurst_{0};
+      std::atomic<int64_t> suppressionWindow_{0};
+
+      std::atomic<size_t> backtraceSize_{0};
+
+      // Counters of the pools replaced by ConfigureQueue
+      std::atomic<uint64_t> overrunBase_{0};
+      std::atomic<uint64_t> discardedBase_{0};
    };
 
-   Logger::Logger()
-      : pimpl_(std::make_unique<Impl>())
+   std::shared_ptr<Logger::Impl::LoggerSet> Logger::Impl::CreateLoggers(const LogQueueConfig& config)
    {
-      // Applications are not expected to burst more than 1024 messages at a time.
-      constexpr size_t QUEUE_SIZE{1024u};
-      constexpr size_t THREAD_COUNT{1u};
-      spdlog::init_thread_pool(QUEUE_SIZE, THREAD_COUNT);
+      // spdlog rejects an empty queue and more than 1000 workers
+      const size_t queueSize = std::max<size_t>(config.queueSize, 1u);
+      const size_t threadCount = std::clamp<size_t>(config.threadCount, 1u, 1000u);
+      // The workers start before the pool is assigned, sinks only look at it once messages arrive
+      auto workerIndex = std::make_shared<std::atomic<size_t>>(0u);
+      auto workerQueue = std::make_shared<std::atomic<spdlog::details::thread_pool*>>(nullptr);
+      auto threadPool = std::make_shared<spdlog::details::thread_pool>(queueSize, threadCount, [name = threadName_, cpus = cpuAffinity_, threadCount, workerIndex, workerQueue] {
+         const auto index = workerIndex->fetch_add(1u);
+         SetupLogThread(threadCount > 1u ? std::format("{}-{}", name, index + 1u) : name, cpus);
+         SetWorkerQueue(workerQueue.get(), threadCount == 1u);
+      });
+      workerQueue->store(threadPool.get(), std::memory_order_release);
 
-      std::vector<spdlog::sink_ptr> sinks;
-      auto& consoleSink{sinks.emplace_back(std::make_shared<spdlog::sinks::stdout_color_sink_mt>())};
-      consoleSink->set_formatter(std::make_unique<AnsiiFormatter>());
+      const std::array<LogOverflowPolicy, LOG_TYPE_COUNT> policies{
+         config.traceOverflow,
+         config.infoOverflow,
+         config.warningOverflow,
+         config.errorOverflow,
+         config.criticalOverflow};
 
-      pimpl_->logger_ = std::make_shared<spdlog::async_logger>("warp-logger",
-                                                               sinks.begin(),
-                                                               sinks.end(),
-                                                               spdlog::thread_pool(),
-                                                               spdlog::async_overflow_policy::block);
+      auto loggers = std::make_shared<LoggerSet>();
+      for (size_t i = 0; i < LOG_TYPE_COUNT; ++i)
+      {
+         auto& logger = loggers->policyLoggers[static_cast<size_t>(policies[i])];
+         if (!logger)
+         {
+            logger = std::make_shared<spdlog::async_logger>("warp-logger",
+                                                            styledSink_,
+                                                            threadPool,
+                                                            ToSpdLogPolicy(policies[i]));
+            // Levels are checked before a message is queued, components can be below the global level
+            logger->set_level(spdlog::level::trace);
+            logger->flush_on(ToSpdLogLevel(flushPolicy_.flushLevel));
+         }
+         loggers->levelLoggers[i] = logger;
+      }
+      loggers->levelPolicies = policies;
+      loggers->queueSize = queueSize;
+      loggers->threadPool = std::move(threadPool);
+      return loggers;
+   }
 
-      bool traceEnabled = false;
-#if defined(_DEBUG) || !defined(NDEBUG)
-      traceEnabled = true;
-#else
+   std::shared_ptr<Logger::Impl::LoggerSet> Logger::Impl::CreateSyncLoggers()
+   {
+      auto logger = std::make_shared<spdlog::logger>("warp-logger", styledSink_);
+      logger->set_level(spdlog::level::trace);
+      logger->flush_on(ToSpdLogLevel(flushPolicy_.flushLevel));
 
-      if (std::getenv("WARP_LOG_TRACE")) traceEnabled = true;
-#endif
-      if (traceEnabled)
+      auto loggers = std::make_shared<LoggerSet>();
+      loggers->policyLoggers[0] = logger;
+      loggers->levelLoggers.fill(logger);
+      return loggers;
+   }
+
+   void Logger::Impl::StartQueue(const LogQueueConfig& config)
+   {
+      // The old loggers and pool are released here, or by the last writer still using them.
+      // Queued messages keep their logger alive and the pool joins its workers once the queue is empty.
+      const auto old = SwapLoggers(CreateLoggers(config));
+
+      // The terminate entries of the old pool look like queued messages to its worker.
+      // A flush behind the last message ends the batch the worker still has open.
+      if (old && old->threadPool)
       {
-         pimpl_->logger_->set_level(spdlog::level::trace);
-         pimpl_->logger_->flush_on(spdlog::level::trace);
+         const auto& flusher = old->policyLoggers[static_cast<size_t>(LogOverflowPolicy::BLOCK)];
+         (flusher ? flusher : old->levelLoggers[0])->flush();
       }
-      else
+
+      styledSink_->SetSinkWorkers(config.sinkWorkers, config.sinkQueueSize, [name = threadName_, cpus = cpuAffinity_](const std::string& suffix) {
+         SetupLogThread(name + suffix, cpus);
+      });
+   }
+
+   std::shared_ptr<Logger::Impl::LoggerSet> Logger::Impl::SwapLoggers(std::shared_ptr<LoggerSet> loggers)
+   {
+      std::unique_lock lock(loggersLock_);
+      if (loggers_ && loggers_->threadPool)
       {
-         pimpl_->logger_->flush_on(spdlog::level::info);
+         overrunBase_ += loggers_->threadPool->overrun_counter();
+         discardedBase_ += loggers_->threadPool->discard_counter();
       }
+      loggers_.swap(loggers);
+      return loggers;
    }
 
-   Logger::~Logger() = default;
+   std::shared_ptr<Logger::Impl::LoggerSet> Logger::Impl::GetLoggers() const
+   {
+      std::shared_lock lock(loggersLock_);
+      return loggers_;
+   }
 
-   void Logger::InitFileLogging(const std::filesystem::path& path, std::string_view filename)
+   std::shared_ptr<spdlog::logger> Logger::Impl::GetLogger(LogType level) const
    {
-      auto p = path / filename;
+      return GetLoggers()->levelLoggers[static_cast<size_t>(level)];
+   }
+
+   void Logger::Impl::Write(LogType level, spdlog::log_clock::time_point time, std::string_view msg, const spdlog::source_loc& source)
+   {
+      // Holds on to the loggers and their pool while they are replaced
+      const auto loggers = GetLoggers();
+      const auto index = static_cast<size_t>(level);
+      auto& logger = *loggers->levelLoggers[index];
+
+      if (sampleCounter_.fetch_add(1, std::memory_order_relaxed) % DEPTH_SAMPLE_INTERVAL == 0)
+      {
+         SampleDepth(*loggers);
+      }
+
+      // Only blocking calls that may find the queue full are timed. The sample is at
+      // most an interval of messages old, unless the writers of other threads raced it.
+      if (loggers->levelPolicies[index] != LogOverflowPolicy::BLOCK
+          || !loggers->threadPool
+          || loggers->lastDepth.load(std::memory_order_relaxed) + DEPTH_SAMPLE_INTERVAL < loggers->queueSize)
+      {
+         logger.log(time, source, ToSpdLogLevel(level), msg);
+         return;
+      }
+
+      const auto start = std::chrono::steady_clock::now();
+      logger.log(time, source, ToSpdLogLevel(level), msg);
+      const auto blocked = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+      blockedNs_.fetch_add(static_cast<uint64_t>(blocked.count()), std::memory_order_relaxed);
+   }
+
+   void Logger::Impl::WriteRecord(const DeferredRecord& record)
+   {
+      const std::string_view bytes(reinterpret_cast<const char*>(&record), record.size);
+      Write(record.level, ToLogTime(record.TimeNanoseconds()), bytes, spdlog::source_loc{DEFERRED_RECORD_SOURCE, 0, nullptr});
+   }
+
+   size_t Logger::Impl::SampleDepth(LoggerSet& loggers)
+   {
+      if (!loggers.threadPool) return 0u;
+
+      const size_t depth = loggers.threadPool->queue_size();
+      loggers.lastDepth.store(depth, std::memory_order_relaxed);
+      size_t seen = highWaterMark_.load(std::memory_order_relaxed);
+      while (depth > seen && !highWaterMark_.compare_exchange_weak(seen, depth, std::memory_order_relaxed))
+      {
+      }
+      return depth;
+   }
+
+   bool Logger::Impl::DrainQueue(const LoggerSet& loggers, std::chrono::steady_clock::time_point deadline)
+   {
+      while (loggers.threadPool && loggers.threadPool->queue_size() > 0u)
+      {
+         if (std::chrono::steady_clock::now() >= deadline) return false;
+         std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      }
+      return true;
+   }
+
+   std::function<void()> Logger::Impl::GetThreadSetup(std::string suffix)
+   {
+      return [name = threadName_ + suffix, cpus = cpuAffinity_] {
+         SetupLogThread(name, cpus);
+      };
+   }
+
+   void Logger::Impl::ClearSinks()
+   {
+      styledSink_->ClearSinks();
+
+      StopNotifications(std::chrono::steady_clock::now() + DEFAULT_SHUTDOWN_TIMEOUT);
+      notifications_.clear();
+      datagrams_.clear();
+   }
+
+   void Logger::Impl::StopNotifications(std::chrono::steady_clock::time_point deadline)
+   {
+      for (const auto& notification : notifications_)
+      {
+         if (!notification.dispatcher->Stop(deadline))
+         {
+            Abandon(notification.dispatcher);
+            Abandon(notification.sink);
+         }
+      }
+   }
+
+   Component& Logger::Impl::FindComponent(std::string_view name)
+   {
+      std::scoped_lock lock(componentsLock_);
+      for (auto& component : components_)
+      {
+         if (component.name == name) return component;
+      }
+      return components_.emplace_back(name);
+   }
+
+   void Logger::Impl::StartFlusher(std::chrono::milliseconds interval)
+   {
+      StopFlusher();
+      if (interval <= std::chrono::milliseconds::zero()) return;
+
+      flusher_ = std::make_unique<std::jthread>([this, interval, setup = GetThreadSetup("-flush")](std::stop_token stopToken) {
+         setup();
+         while (!stopToken.stop_requested())
+         {
+            {
+               std::unique_lock lock(flushLock_);
+               flushWakeup_.wait_for(lock, stopToken, interval, [] { return false; });
+            }
+            if (stopToken.stop_requested()) break;
+
+            FlushSuppression();
+
+            // Locks the sink, so this waits for a message the worker is writing
+            styledSink_->flush();
+         }
+      });
+   }
+
+   void Logger::Impl::FlushSuppression()
+   {
+      const auto burst = suppressionBurst_.load(std::memory_order_relaxed);
+      if (burst == 0u) return;
+
+      const auto now = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+      const auto window = suppressionWindow_.load(std::memory_order_relaxed);
+      for (auto& slot : suppression_)
+      {
+         auto count = slot.count.load(std::memory_order_relaxed);
+         if (count <= burst || now - slot.windowStart.load(std::memory_order_relaxed) < window) continue;
+
+         // A call starting the next window may have taken the count first
+         const auto site = slot.site.load(std::memory_order_relaxed);
+         if (!slot.count.compare_exchange_strong(count, 0u, std::memory_order_relaxed)) continue;
+
+         auto level = LogType::INFO;
+         const auto summary = TakeSuppressionSummary(slot, site, count - burst, level);
+         Write(level, spdlog::log_clock::now(), summary);
+      }
+   }
+
+   void Logger::Impl::StopFlusher()
+   {
+      if (!flusher_) return;
+
+      flusher_->request_stop();
+      flusher_->join();
+      flusher_.reset();
+   }
+
+   // Set before any logger exists, so IsEnabled is right before the first Instance call
+   std::atomic<LogType> Logger::activeLevel_{DefaultLevel()};
+
+   Logger::Logger()
+      : pimpl_(std::make_unique<Impl>())
+   {
+      // All sinks hang off the styled sink so message styles are resolved once per message
+      pimpl_->styledSink_ = std::make_shared<StyledDistSink>();
 
+      pimpl_->consoleSink_ = std::make_shared<ConsoleSink>();
+      pimpl_->consoleSink_->set_formatter(std::make_unique<AnsiiFormatter>());
+
+      // Each producing thread gets its own ring. Sized for a burst of a few hundred records.
+      constexpr size_t DEFERRED_RING_SIZE{64u * 1024u};
+      pimpl_->deferred_ = std::make_unique<DeferredBackend>(DEFERRED_RING_SIZE, [this](const DeferredRecord& record) {
+         pimpl_->WriteRecord(record);
+      });
+
+      if (const auto* levels = std::getenv("WARP_LOG_LEVELS")) SetComponentLevels(levels);
+
+      // The logging threads start here, with the settings of Configure if it created the logger
+      std::optional<LogConfig> pending;
+      {
+         std::scoped_lock lock(PendingConfigLock());
+         pending.swap(PendingConfig());
+      }
+      Apply(pending ? *pending : LogConfig{});
+   }
+
+   Logger::~Logger()
+   {
+      // Write out anything still captured or queued before the sinks go away
+      Shutdown();
+   }
+
+   template <typename CreateSink>
+   void Logger::Impl::AddFileSink(const std::filesystem::path& p, std::string_view description, SinkOutput output, CreateSink&& create)
+   {
       std::error_code ec;
       std::filesystem::create_directories(p.parent_path(), ec);
 
       if (ec)
       {
-         pimpl_->logger_->warn("Failed to create log directory {}: {}", p.parent_path().string(), ec.message());
+         GetLogger(LogType::WARN)->warn("Failed to create log directory {}: {}", p.parent_path().string(), ec.message());
          return;
       }
 
-      constexpr size_t max_size{1048576 * 5};
-      constexpr size_t max_files{5};
-
       try
       {
-         auto fileSink = std::make_shared<spdlog::sinks::rotating_file_sink_mt>(p.string(), max_size, max_files);
-         fileSink->set_formatter(std::make_unique<AnsiiRemoveFormatter>());
-         pimpl_->logger_->sinks().push_back(fileSink);
+         styledSink_->AddSink(create(), output, SinkClass::FILE);
       }
       catch (const std::exception& e)
       {
-         pimpl_->logger_->warn("Failed to initialize file logging {}: {}", p.string(), e.what());
+         GetLogger(LogType::WARN)->warn("Failed to initialize {} {}: {}", description, p.string(), e.what());
       }
    }
 
+   void Logger::InitFileLogging(const std::filesystem::path& path, std::string_view filename, const FileLoggingConfig& config)
+   {
+      auto p = path / filename;
+      pimpl_->AddFileSink(p, "file logging", SinkOutput::PLAIN, [&p, &config] {
+         auto fileSink = std::make_shared<MappedFileSink>(p, config);
+         fileSink->set_formatter(std::make_unique<PlainFormatter>());
+         return fileSink;
+      });
+   }
+
+   void Logger::InitBinaryFileLogging(const std::filesystem::path& path, std::string_view filename, const FileLoggingConfig& config)
+   {
+      auto p = path / filename;
+      pimpl_->AddFileSink(p, "binary file logging", SinkOutput::PLAIN, [&p, &config] {
+         return std::make_shared<BinaryFileSink>(p, config);
+      });
+      records_ = true;
+   }
+
+   void Logger::InitJsonLogging(const std::filesystem::path& path, std::string_view filename, const FileLoggingConfig& config)
+   {
+      auto p = path / filename;
+      pimpl_->AddFileSink(p, "json logging", SinkOutput::STRUCTURED, [&p, &config] {
+         return std::make_shared<JsonLinesSink>(p, config);
+      });
+   }
+
    void Logger::InitApprise(const AppriseLoggingConfig& config)
    {
-      auto app_sink = std::make_shared<apprise_sink_mt>(config);
+      auto app_sink = std::make_shared<apprise_sink_mt>(config, pimpl_->GetThreadSetup("-apprise"));
+      pimpl_->notifications_.push_back({app_sink, app_sink->GetDispatcher()});
 
       // Only notify on Warnings and Errors
       app_sink->set_level(spdlog::level::warn);
@@ -116,12 +647,13 @@ namespace warp
       // Clean pattern for mobile/email notifications (No colors)
       app_sink->set_pattern("[%l] %v");
 
-      pimpl_->logger_->sinks().push_back(app_sink);
+      pimpl_->styledSink_->AddSink(app_sink, SinkOutput::PLAIN, SinkClass::NETWORK);
    }
 
    void Logger::InitGotify(const GotifyLoggingConfig& config)
    {
-      auto app_sink = std::make_shared<gotify_sink_mt>(config);
+      auto app_sink = std::make_shared<gotify_sink_mt>(config, pimpl_->GetThreadSetup("-gotify"));
+      pimpl_->notifications_.push_back({app_sink, app_sink->GetDispatcher()});
 
       // Only notify on Warnings and Errors
       app_sink->set_level(spdlog::level::warn);
@@ -129,17 +661,363 @@ namespace warp
       // Clean pattern for mobile/email notifications (No colors)
       app_sink->set_pattern("[%l] %v");
 
-      pimpl_->logger_->sinks().push_back(app_sink);
+      pimpl_->styledSink_->AddSink(app_sink, SinkOutput::PLAIN, SinkClass::NETWORK);
    }
 
-   void Logger::LogInternal(LogType level, std::string_view msg)
+   void Logger::InitDatagramLogging(const DatagramLoggingConfig& config)
+   {
+      try
+      {
+         auto sink = std::make_shared<DatagramSink>(config);
+         pimpl_->datagrams_.push_back(sink);
+
+         // JSON records carry the fields, binary ones the plain text
+         const auto output = config.format == LogDatagramFormat::JSON ? SinkOutput::STRUCTURED : SinkOutput::PLAIN;
+         pimpl_->styledSink_->AddSink(sink, output, SinkClass::NETWORK);
+      }
+      catch (const std::exception& e)
+      {
+         pimpl_->GetLogger(LogType::WARN)->warn("Failed to initialize datagram logging {}: {}", config.socketPath.string(), e.what());
+      }
+   }
+
+   void Logger::Configure(const LogConfig& config)
+   {
+      {
+         std::scoped_lock lock(PendingConfigLock());
+         PendingConfig() = config;
+      }
+
+      auto& logger = Instance();
+
+      // Taken by the constructor unless the logger existed before
+      std::optional<LogConfig> pending;
+      {
+         std::scoped_lock lock(PendingConfigLock());
+         pending.swap(PendingConfig());
+      }
+      if (!pending) return;
+
+      // The logger was already in use, its workers and sinks are replaced
+      logger.Apply(*pending);
+      logger.LogInternal(LogType::WARN, "Configure was called after the logger was in use, its queue and sinks were replaced");
+   }
+
+   void Logger::Apply(const LogConfig& config)
+   {
+      std::unique_lock lock(pimpl_->configureLock_);
+      if (pimpl_->shutDown_)
+      {
+         lock.unlock();
+         LogInternal(LogType::WARN, "The logger is shut down, the configuration is ignored");
+         return;
+      }
+
+      if (config.level) activeLevel_ = *config.level;
+      const bool clockSet = LogClock::SetSource(config.clock);
+
+      pimpl_->threadName_ = config.threadName;
+      pimpl_->cpuAffinity_ = config.cpuAffinity;
+      pimpl_->deferred_->SetThreadSetup(pimpl_->GetThreadSetup("-fmt"));
+      StartQueue(config.queue);
+      SetFlushPolicy(config.flush);
+
+      // Sinks of an earlier configuration would write every message twice
+      pimpl_->ClearSinks();
+      records_ = false;
+      if (config.console) pimpl_->styledSink_->AddSink(pimpl_->consoleSink_, SinkOutput::ANSI, SinkClass::CONSOLE);
+
+      if (config.textFile) InitFileLogging(config.textFile->path, config.textFile->filename, config.textFile->config);
+      if (config.binaryFile) InitBinaryFileLogging(config.binaryFile->path, config.binaryFile->filename, config.binaryFile->config);
+      if (config.jsonFile) InitJsonLogging(config.jsonFile->path, config.jsonFile->filename, config.jsonFile->config);
+      if (config.apprise) InitApprise(*config.apprise);
+      if (config.gotify) InitGotify(*config.gotify);
+      if (config.datagram) InitDatagramLogging(*config.datagram);
+
+      if (!clockSet) LogInternal(LogType::WARN, "No invariant TSC on this CPU, log records use the system clock");
+   }
+
+   void Logger::SetLevel(LogType level)
+   {
+      activeLevel_ = level;
+   }
+
+   const Logger::ComponentLevel& Logger::RegisterComponent(std::string_view name)
+   {
+      return pimpl_->FindComponent(name).level;
+   }
+
+   void Logger::SetComponentLevel(std::string_view name, std::optional<LogType> level)
+   {
+      // Setting the level of a component that does not exist yet creates it
+      pimpl_->FindComponent(name).level = level.has_value() ? static_cast<int8_t>(*level) : COMPONENT_LEVEL_GLOBAL;
+   }
+
+   bool Logger::SetComponentLevels(std::string_view levels)
+   {
+      bool valid{true};
+      while (!levels.empty())
+      {
+         const auto end = levels.find_first_of(",;");
+         const auto entry = levels.substr(0, end);
+         levels = end == std::string_view::npos ? std::string_view{} : levels.substr(end + 1u);
+
+         if (Trim(entry).empty()) continue;
+
+         const auto separator = entry.rfind('=');
+         std::optional<LogType> level;
+         if (separator == std::string_view::npos || !ParseComponentLevel(Trim(entry.substr(separator + 1u)), level))
+         {
+            valid = false;
+            continue;
+         }
+         SetComponentLevel(Trim(entry.substr(0, separator)), level);
+      }
+      return valid;
+   }
+
+   void Logger::SetDeferredFormatting(bool enabled)
+   {
+      if (enabled)
+      {
+         pimpl_->deferred_->Start();
+         deferred_ = true;
+      }
+      else
+      {
+         deferred_ = false;
+         pimpl_->deferred_->Stop();
+      }
+   }
+
+   void Logger::SetBacktrace(size_t bytesPerThread)
+   {
+      pimpl_->backtraceSize_ = bytesPerThread;
+      backtrace_ = bytesPerThread > 0u;
+   }
+
+   void Logger::DumpBacktrace()
+   {
+      if (!backtraceRing) return;
+
+      while (const auto* record = backtraceRing->Peek())
+      {
+         pimpl_->WriteRecord(*record);
+         backtraceRing->Pop(record);
+      }
+   }
+
+   DeferredRing& Logger::GetRecordRing()
+   {
+      if (!recordRing) recordRing = std::make_unique<DeferredRing>(RECORD_RING_SIZE);
+      return *recordRing;
+   }
+
+   void Logger::WriteRecordRing(DeferredRing& ring)
+   {
+      while (const auto* record = ring.Peek())
+      {
+         pimpl_->WriteRecord(*record);
+         ring.Pop(record);
+      }
+   }
+
+   DeferredRing* Logger::GetBacktraceRing()
+   {
+      const size_t size = pimpl_->backtraceSize_.load(std::memory_order_relaxed);
+      if (size == 0u)
+      {
+         backtraceRing.reset();
+         return nullptr;
+      }
+
+      if (!backtraceRing || backtraceRing->MaxRecordSize() != std::bit_ceil(size) / 2u)
+      {
+         backtraceRing = std::make_unique<DeferredRing>(size);
+      }
+      return backtraceRing.get();
+   }
+
+   void Logger::ConfigureQueue(const LogQueueConfig& config)
+   {
+      std::scoped_lock lock(pimpl_->configureLock_);
+      if (pimpl_->shutDown_) return;
+      StartQueue(config);
+   }
+
+   void Logger::StartQueue(const LogQueueConfig& config)
+   {
+      overflow_[static_cast<size_t>(LogType::TRACE)] = config.traceOverflow;
+      overflow_[static_cast<size_t>(LogType::INFO)] = config.infoOverflow;
+      overflow_[static_cast<size_t>(LogType::WARN)] = config.warningOverflow;
+      overflow_[static_cast<size_t>(LogType::ERR)] = config.errorOverflow;
+      overflow_[static_cast<size_t>(LogType::CRITICAL)] = config.criticalOverflow;
+      pimpl_->StartQueue(config);
+   }
+
+   LogQueueStats Logger::GetQueueStats() const
+   {
+      const auto loggers = pimpl_->GetLoggers();
+      const auto& pool = loggers->threadPool;
+
+      LogQueueStats stats;
+      stats.queueSize = loggers->queueSize;
+      stats.queueDepth = pimpl_->SampleDepth(*loggers);
+      stats.highWaterMark = pimpl_->highWaterMark_.load(std::memory_order_relaxed);
+      stats.overrun = pimpl_->overrunBase_ + (pool ? pool->overrun_counter() : 0u);
+      stats.discarded = pimpl_->discardedBase_ + deferredDiscarded_.load(std::memory_order_relaxed) + (pool ? pool->discard_counter() : 0u);
+      stats.blockedTime = std::chrono::nanoseconds(pimpl_->blockedNs_.load(std::memory_order_relaxed));
+      return stats;
+   }
+
+   void Logger::SetFlushPolicy(const LogFlushPolicy& policy)
+   {
+      pimpl_->flushPolicy_ = policy;
+      for (const auto& logger : pimpl_->GetLoggers()->policyLoggers)
+      {
+         if (logger) logger->flush_on(ToSpdLogLevel(policy.flushLevel));
+      }
+      pimpl_->styledSink_->SetFlushThreshold(policy.maxPendingBytes);
+      pimpl_->StartFlusher(policy.interval);
+   }
+
+   void Logger::SetSuppression(const LogSuppressionConfig& config)
+   {
+      pimpl_->suppressionBurst_ = config.burst;
+      pimpl_->suppressionWindow_ = std::chrono::duration_cast<std::chrono::nanoseconds>(config.window).count();
+      suppress_ = config.burst > 0u;
+   }
+
+   void Logger::Shutdown(std::chrono::milliseconds timeout)
+   {
+      const auto deadline = std::chrono::steady_clock::now() + timeout;
+
+      std::scoped_lock lock(pimpl_->configureLock_);
+      if (pimpl_->shutDown_) return;
+      pimpl_->shutDown_ = true;
+
+      deferred_ = false;
+      pimpl_->deferred_->Stop();
+      pimpl_->StopFlusher();
+
+      // Messages logged from here on are written on the calling thread
+      auto loggers = pimpl_->SwapLoggers(pimpl_->CreateSyncLoggers());
+
+      // Workers still writing at the deadline, for example to a stuck sink, are left to
+      // finish on their own. Destroying the pool or the sink would join them.
+      const bool flushed = Impl::DrainQueue(*loggers, deadline)
+         && pimpl_->styledSink_->Flush(deadline)
+         && pimpl_->styledSink_->WaitForSinkWorkers(deadline);
+      if (!flushed)
+      {
+         Abandon(loggers);
+         Abandon(pimpl_->styledSink_);
+      }
+
+      // Unless left behind the queue is empty and the workers of the pool exit right away
+      loggers.reset();
+
+      // Notification workers can be stuck sending to an unreachable endpoint
+      pimpl_->StopNotifications(deadline);
+   }
+
+   std::vector<NotificationStats> Logger::GetNotificationStats() const
+   {
+      std::vector<NotificationStats> stats;
+      stats.reserve(pimpl_->notifications_.size());
+      for (const auto& notification : pimpl_->notifications_)
+      {
+         stats.push_back(notification.dispatcher->GetStats());
+      }
+      return stats;
+   }
+
+   std::vector<DatagramStats> Logger::GetDatagramStats() const
    {
-      pimpl_->logger_->log(ToSpdLogLevel(level), msg);
+      std::vector<DatagramStats> stats;
+      stats.reserve(pimpl_->datagrams_.size());
+      for (const auto& sink : pimpl_->datagrams_)
+      {
+         stats.push_back(sink->GetStats());
+      }
+      return stats;
    }
 
-   bool Logger::ShouldLog(LogType level)
+   std::vector<LogRecord> Logger::QueryFileLog(const std::filesystem::path& path, std::string_view filename, const LogQuery& query)
    {
-      return pimpl_->logger_->should_log(ToSpdLogLevel(level));
+      // Lets the sinks write what is queued and bring their indexes up to date
+      const auto deadline = std::chrono::steady_clock::now() + DEFAULT_SHUTDOWN_TIMEOUT;
+      Impl::DrainQueue(*pimpl_->GetLoggers(), deadline);
+      pimpl_->styledSink_->Flush(deadline);
+      pimpl_->styledSink_->WaitForSinkWorkers(deadline);
+
+      return QueryLogFiles(path / filename, query);
+   }
+
+   DeferredRing& Logger::GetThreadRing()
+   {
+      return pimpl_->deferred_->GetThreadRing();
+   }
+
+   bool Logger::WaitForDeferredSpace()
+   {
+      return pimpl_->deferred_->WaitForSpace();
+   }
+
+   void Logger::FlushDeferred()
+   {
+      pimpl_->deferred_->Flush();
+   }
+
+   bool Logger::PassSuppression(LogType level, const std::string_view* header, std::string_view fmt)
+   {
+      // Base objects share their format strings, tell them apart by the header text.
+      // Its address can change between calls of the same object.
+      auto site = reinterpret_cast<uintptr_t>(fmt.data());
+      if (header != nullptr) site ^= std::hash<std::string_view>{}(*header) << 1;
+
+      auto& slot = pimpl_->suppression_[GetSuppressionSlot(site)];
+      const auto now = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+      const auto burst = pimpl_->suppressionBurst_.load(std::memory_order_relaxed);
+
+      if (slot.site.load(std::memory_order_relaxed) == site
+          && now - slot.windowStart.load(std::memory_order_relaxed) < pimpl_->suppressionWindow_.load(std::memory_order_relaxed))
+      {
+         const auto count = slot.count.fetch_add(1, std::memory_order_relaxed);
+         if (count != burst) return count < burst;
+
+         // The first suppressed call describes the site for the summary
+         std::scoped_lock lock(slot.summaryLock);
+         slot.summarySite = site;
+         slot.summaryLevel = level;
+         slot.summary = header != nullptr ? std::format("{}: \"{}\"", *header, fmt) : std::format("\"{}\"", fmt);
+         return false;
+      }
+
+      // A new window or another call site, which reports the calls suppressed before.
+      // Threads racing here can miscount a few messages.
+      const auto previousSite = slot.site.exchange(site, std::memory_order_relaxed);
+      const auto previousCount = slot.count.exchange(1, std::memory_order_relaxed);
+      slot.windowStart.store(now, std::memory_order_relaxed);
+
+      if (previousCount > burst)
+      {
+         auto summaryLevel = level;
+         LogInternal(summaryLevel, TakeSuppressionSummary(slot, previousSite, previousCount - burst, summaryLevel));
+      }
+      return true;
+   }
+
+   void Logger::LogInternal(LogType level, std::string_view msg)
+   {
+      // Keep already formatted messages behind the records this thread captured earlier
+      if (deferred_.load(std::memory_order_relaxed) && LogDeferred(level, nullptr, "{}", msg))
+      {
+         return;
+      }
 
+      // spdlog carries a time point. Converting ticks here would cost the caller more
+      // than reading the system clock, so only deferred records are stamped with ticks.
+      pimpl_->Write(level, spdlog::log_clock::now(), msg);
    }
 }
\ No newline at end of file
@@ -0,0 +1,326 @@
+#include "mapped-file-sink.h"
+
+#include "file-rotation.h"
+
+#include <spdlog/common.h>
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstring>
+#include <format>
+#include <string>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace warp
+{
+#if !defined(_WIN32)
+   namespace
+   {
+      // Reserves the blocks of the file up to the capacity. Writes into a sparse mapping
+      // fault with SIGBUS once the disk is full, so blocks the file system can not
+      // reserve are written with zeros instead.
+      bool Preallocate(int file, size_t capacity)
+      {
+#if defined(__linux__)
+         if (::posix_fallocate(file, 0, static_cast<off_t>(capacity)) == 0) return true;
+#endif
+
+         struct stat fileStat{};
+         if (::fstat(file, &fileStat) != 0) return false;
+         auto offset = static_cast<size_t>(fileStat.st_size);
+         if (offset >= capacity) return true;
+
+#if defined(__APPLE__)
+         fstore_t store{F_ALLOCATEALL, F_PEOFPOSMODE, 0, static_cast<off_t>(capacity - offset), 0};
+         if (::fcntl(file, F_PREALLOCATE, &store) != -1 && ::ftruncate(file, static_cast<off_t>(capacity)) == 0) return true;
+#endif
+
+         static constexpr std::array<char, 64u * 1024u> zeros{};
+         while (offset < capacity)
+         {
+            const auto written = ::pwrite(file, zeros.data(), std::min(zeros.size(), capacity - offset), static_cast<off_t>(offset));
+            if (written < 0 && errno == EINTR) continue;
+            if (written <= 0) return false;
+            offset += static_cast<size_t>(written);
+         }
+         return true;
+      }
+   }
+#endif
+
+   MappedFileSink::MappedFileSink(std::filesystem::path path, const FileLoggingConfig& config)
+      : path_(std::move(path))
+      , config_(config)
+   {
+      Open();
+   }
+
+   MappedFileSink::~MappedFileSink()
+   {
+      Close();
+   }
+
+   void MappedFileSink::sink_it_(const spdlog::details::log_msg& msg)
+   {
+      spdlog::memory_buf_t formatted;
+      formatter_->format(msg, formatted);
+
+      // Reopen if a rotation or growing the mapping failed earlier
+      if (data_ == nullptr)
+      {
+         Close();
+         Open();
+      }
+
+      const size_t length = formatted.size();
+      if (size_ > 0u && size_ + length > config_.maxFileSize)
+      {
+         Rotate();
+      }
+
+      // A line longer than a whole file still goes into a single file
+      if (size_ + length > capacity_)
+      {
+         Map(size_ + length);
+      }
+
+      if (config_.timeIndex)
+      {
+         index_.Add(static_cast<int64_t>(spdlog::log_clock::to_time_t(msg.time)), msg.level, size_);
+      }
+
+      std::memcpy(data_ + size_, formatted.data(), length);
+      size_ += length;
+   }
+
+   bool MappedFileSink::FlushPending() const
+   {
+      return syncPending_.load(std::memory_order_relaxed);
+   }
+
+   void MappedFileSink::flush_()
+   {
+      // Kept current for queries, which read the file while it is written
+      index_.Flush();
+
+      // The styled sink flushes again on its next timer tick while the sync is pending
+      const auto now = std::chrono::steady_clock::now();
+      if (now - lastSync_ < config_.syncInterval)
+      {
+         syncPending_.store(size_ > syncedSize_, std::memory_order_relaxed);
+         return;
+      }
+
+      Sync();
+      lastSync_ = now;
+      syncPending_.store(false, std::memory_order_relaxed);
+   }
+
+   void MappedFileSink::Rotate()
+   {
+      Close();
+      RotateLogFile(path_, config_);
+      Open();
+   }
+
+#if defined(_WIN32)
+   void MappedFileSink::Open()
+   {
+      file_ = CreateFileW(path_.c_str(),
+                          GENERIC_READ | GENERIC_WRITE,
+                          FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                          nullptr,
+                          OPEN_ALWAYS,
+                          FILE_ATTRIBUTE_NORMAL,
+                          nullptr);
+      if (file_ == INVALID_HANDLE_VALUE)
+      {
+         file_ = nullptr;
+         spdlog::throw_spdlog_ex(std::format("Failed to open log file {}", path_.string()));
+      }
+
+      LARGE_INTEGER fileSize{};
+      GetFileSizeEx(file_, &fileSize);
+      const auto existing = static_cast<size_t>(fileSize.QuadPart);
+      try
+      {
+         Map(std::max({existing, config_.maxFileSize, size_t{1u}}));
+      }
+      catch (...)
+      {
+         CloseHandle(file_);
+         file_ = nullptr;
+         throw;
+      }
+
+      // Continue after the last line written before a restart or crash
+      size_ = existing;
+      while (size_ > 0u && data_[size_ - 1u] == '\0') --size_;
+      syncedSize_ = size_;
+      lastSync_ = std::chrono::steady_clock::now();
+      if (config_.timeIndex) index_.Open(path_, size_);
+   }
+
+   void MappedFileSink::Close()
+   {
+      if (file_ == nullptr) return;
+
+      index_.Close();
+      Unmap();
+
+      LARGE_INTEGER end{};
+      end.QuadPart = static_cast<LONGLONG>(size_);
+      SetFilePointerEx(file_, end, nullptr, FILE_BEGIN);
+      SetEndOfFile(file_);
+      CloseHandle(file_);
+
+      file_ = nullptr;
+      size_ = 0u;
+      syncedSize_ = 0u;
+   }
+
+   void MappedFileSink::Sync()
+   {
+      if (data_ == nullptr || size_ <= syncedSize_) return;
+
+      FlushViewOfFile(data_ + syncedSize_, size_ - syncedSize_);
+      FlushFileBuffers(file_);
+      syncedSize_ = size_;
+   }
+
+   void MappedFileSink::Map(size_t capacity)
+   {
+      Unmap();
+
+      LARGE_INTEGER end{};
+      end.QuadPart = static_cast<LONGLONG>(capacity);
+      if (!SetFilePointerEx(file_, end, nullptr, FILE_BEGIN) || !SetEndOfFile(file_))
+      {
+         spdlog::throw_spdlog_ex(std::format("Failed to preallocate log file {}", path_.string()));
+      }
+
+      mapping_ = CreateFileMappingW(file_, nullptr, PAGE_READWRITE, static_cast<DWORD>(end.HighPart), end.LowPart, nullptr);
+      if (mapping_ == nullptr)
+      {
+         spdlog::throw_spdlog_ex(std::format("Failed to map log file {}", path_.string()));
+      }
+
+      data_ = static_cast<char*>(MapViewOfFile(mapping_, FILE_MAP_WRITE, 0, 0, capacity));
+      if (data_ == nullptr)
+      {
+         spdlog::throw_spdlog_ex(std::format("Failed to map log file {}", path_.string()));
+      }
+      capacity_ = capacity;
+   }
+
+   void MappedFileSink::Unmap()
+   {
+      if (data_ != nullptr) UnmapViewOfFile(data_);
+      if (mapping_ != nullptr) CloseHandle(mapping_);
+
+      data_ = nullptr;
+      mapping_ = nullptr;
+      capacity_ = 0u;
+   }
+#else
+   void MappedFileSink::Open()
+   {
+      file_ = ::open(path_.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+      if (file_ < 0)
+      {
+         spdlog::throw_spdlog_ex(std::format("Failed to open log file {}", path_.string()), errno);
+      }
+
+      struct stat fileStat{};
+      ::fstat(file_, &fileStat);
+      const auto existing = static_cast<size_t>(fileStat.st_size);
+      try
+      {
+         Map(std::max({existing, config_.maxFileSize, size_t{1u}}));
+      }
+      catch (...)
+      {
+         ::close(file_);
+         file_ = -1;
+         throw;
+      }
+
+      // Continue after the last line written before a restart or crash
+      size_ = existing;
+      while (size_ > 0u && data_[size_ - 1u] == '\0') --size_;
+      syncedSize_ = size_;
+      lastSync_ = std::chrono::steady_clock::now();
+      if (config_.timeIndex) index_.Open(path_, size_);
+   }
+
+   void MappedFileSink::Close()
+   {
+      if (file_ < 0) return;
+
+      index_.Close();
+      Unmap();
+
+      // On failure the zero filled tail stays behind and is skipped when the file is reopened
+      [[maybe_unused]] const int trimmed = ::ftruncate(file_, static_cast<off_t>(size_));
+      ::close(file_);
+
+      file_ = -1;
+      size_ = 0u;
+      syncedSize_ = 0u;
+   }
+
+   void MappedFileSink::Sync()
+   {
+      if (data_ == nullptr || size_ <= syncedSize_) return;
+
+      // msync wants a page aligned start
+      static const auto pageSize = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+      const size_t offset = syncedSize_ - (syncedSize_ % pageSize);
+      ::msync(data_ + offset, size_ - offset, MS_SYNC);
+      syncedSize_ = size_;
+   }
+
+   void MappedFileSink::Map(size_t capacity)
+   {
+      Unmap();
+
+      // Reserve the blocks up front so the file system does not allocate on page faults
+      if (!Preallocate(file_, capacity))
+      {
+         spdlog::throw_spdlog_ex(std::format("Failed to preallocate log file {}", path_.string()), errno);
+      }
+
+      void* data = ::mmap(nullptr, capacity, PROT_READ | PROT_WRITE, MAP_SHARED, file_, 0);
+      if (data == MAP_FAILED)
+      {
+         spdlog::throw_spdlog_ex(std::format("Failed to map log file {}", path_.string()), errno);
+      }
+
+      data_ = static_cast<char*>(data);
+      capacity_ = capacity;
+   }
+
+   void MappedFileSink::Unmap()
+   {
+      if (data_ != nullptr) ::munmap(data_, capacity_);
+
+      data_ = nullptr;
+      capacity_ = 0u;
+   }
+#endif
+}
\ No newline at end of file
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "warp/log/log-types.h"
+
+#include "log-index.h"
+#include "styled-dist-sink.h"
+
+#include <spdlog/sinks/base_sink.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <filesystem>
+#include <mutex>
+
+namespace warp
+{
+   // Rotating file sink that writes into a preallocated, memory mapped file so a
+   // line costs a copy instead of a write call. Files rotate like spdlog's
+   // rotating_file_sink (log.txt -> log.1.txt -> ...). The unused tail of the file
+   // stays zero filled, after a crash the log ends at the first zero byte and
+   // writing resumes there. Files are trimmed to their content when closed. With
+   // timeIndex each file gets a LogIndexWriter sidecar.
+   class MappedFileSink : public spdlog::sinks::base_sink<std::mutex>, public ThrottledFlushSink
+   {
+   public:
+      MappedFileSink(std::filesystem::path path, const FileLoggingConfig& config);
+      ~MappedFileSink() override;
+
+      // True while a flush within the sync interval left lines unsynced
+      [[nodiscard]] bool FlushPending() const override;
+
+   protected:
+      void sink_it_(const spdlog::details::log_msg& msg) override;
+
+      // Syncs the mapping to disk at most once per sync interval
+      void flush_() override;
+
+   private:
+      void Open();
+      void Close();
+      void Rotate();
+      void Sync();
+
+      // Grows or maps the file to the capacity. The new space reads as zeros.
+      void Map(size_t capacity);
+      void Unmap();
+
+      std::filesystem::path path_;
+      FileLoggingConfig config_;
+
+#if defined(_WIN32)
+      void* file_{nullptr};
+      void* mapping_{nullptr};
+#else
+      int file_{-1};
+#endif
+      char* data_{nullptr};
+      size_t capacity_{0};
+      size_t size_{0};
+
+      size_t syncedSize_{0};
+      std::chrono::steady_clock::time_point lastSync_;
+      std::atomic_bool syncPending_{false};
+
+      LogIndexWriter index_;
+   };
+}
\ No newline at end of file
@@ -0,0 +1,137 @@
+#include "notification-dispatcher.h"
+
+#include <algorithm>
+#include <exception>
+#include <format>
+
+namespace warp
+{
+   NotificationDispatcher::NotificationDispatcher(std::string name, const NotificationLimits& limits, Sender sender, std::function<void()> threadSetup)
+      : name_(std::move(name))
+      , limits_(limits)
+      , sender_(std::move(sender))
+   {
+      thread_ = std::make_unique<std::jthread>([this, setup = std::move(threadSetup)](std::stop_token stopToken) {
+         if (setup) setup();
+         Work(stopToken);
+
+         std::scoped_lock lock(queueLock_);
+         finished_ = true;
+         queueCondition_.notify_all();
+      });
+   }
+
+   NotificationDispatcher::~NotificationDispatcher()
+   {
+      Stop();
+   }
+
+   void NotificationDispatcher::Post(std::string message)
+   {
+      {
+         std::scoped_lock lock(queueLock_);
+         if (queue_.size() >= limits_.queueSize)
+         {
+            ++dropped_;
+            return;
+         }
+         queue_.push_back(std::move(message));
+      }
+      queueCondition_.notify_one();
+   }
+
+   void NotificationDispatcher::Stop()
+   {
+      if (!thread_) return;
+
+      thread_->request_stop();
+      thread_->join();
+      thread_.reset();
+
+      std::scoped_lock lock(queueLock_);
+      dropped_ += queue_.size();
+      queue_.clear();
+   }
+
+   bool NotificationDispatcher::Stop(std::chrono::steady_clock::time_point deadline)
+   {
+      if (!thread_) return true;
+
+      thread_->request_stop();
+      {
+         std::unique_lock lock(queueLock_);
+         if (!queueCondition_.wait_until(lock, deadline, [this] { return finished_; }))
+         {
+            thread_->detach();
+            thread_.reset();
+            return false;
+         }
+      }
+
+      Stop();
+      return true;
+   }
+
+   NotificationStats NotificationDispatcher::GetStats() const
+   {
+      return {
+         .name = name_,
+         .sent = sent_,
+         .coalesced = coalesced_,
+         .dropped = dropped_
+      };
+   }
+
+   void NotificationDispatcher::Work(std::stop_token stopToken)
+   {
+      auto nextSendTime = std::chrono::steady_clock::now();
+
+      while (true)
+      {
+         std::deque<std::string> messages;
+         {
+            // Once stopping, what is still queued goes out right away, for example a critical just before exit
+            std::unique_lock lock(queueLock_);
+            if (!queueCondition_.wait(lock, stopToken, [this] { return !queue_.empty(); })) break;
+
+            // Let the rest of a burst arrive, then respect the minimum interval between sends
+            auto sendTime = std::max(std::chrono::steady_clock::now() + limits_.coalesceWindow, nextSendTime);
+            queueCondition_.wait_until(lock, stopToken, sendTime, [] { return false; });
+
+            messages.swap(queue_);
+         }
+
+         auto message = messages.size() == 1 ? std::move(messages.front()) : BuildDigest(messages);
+         try
+         {
+            sender_(message);
+         }
+         catch (const std::exception&)
+         {
+            // Nothing to log to from here, the message is lost
+         }
+
+         ++sent_;
+         coalesced_ += messages.size() - 1;
+         nextSendTime = std::chrono::steady_clock::now() + limits_.minInterval;
+      }
+   }
+
+   std::string NotificationDispatcher::BuildDigest(const std::deque<std::string>& messages) const
+   {
+      auto digest = std::format("{} messages", messages.size());
+
+      size_t lines{0};
+      for (const auto& message : messages)
+      {
+         if (lines++ == limits_.maxDigestLines)
+         {
+            digest.append(std::format("\n... and {} more", messages.size() - limits_.maxDigestLines));
+            break;
+         }
+         digest.append("\n");
+         digest.append(message);
+      }
+      return digest;
+   }
+}
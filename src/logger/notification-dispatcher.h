@@ -0,0 +1,65 @@
+#pragma once
+
+#include "warp/log/log-types.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace warp
+{
+   // Sends notifications for a sink from its own bounded queue and worker so a slow
+   // or unreachable endpoint never holds up the logging thread. Bursts are coalesced
+   // into a digest and sends are spaced by the configured minimum interval.
+   class NotificationDispatcher
+   {
+   public:
+      using Sender = std::function<void(const std::string& message)>;
+
+      // The setup runs on the worker when it starts, for example to name it
+      NotificationDispatcher(std::string name, const NotificationLimits& limits, Sender sender, std::function<void()> threadSetup = {});
+      ~NotificationDispatcher();
+
+      // Queues a message without blocking. Dropped if the queue is full.
+      void Post(std::string message);
+
+      // Stops the worker after it sent what is queued, as one digest without waiting
+      // for the coalesce window or the minimum interval. Messages posted after the
+      // worker exited are counted as dropped.
+      void Stop();
+
+      // Stops the worker unless it is still sending at the deadline. Then the worker is
+      // detached and false is returned, the dispatcher and everything the sender uses
+      // must be kept alive from then on.
+      bool Stop(std::chrono::steady_clock::time_point deadline);
+
+      [[nodiscard]] NotificationStats GetStats() const;
+
+   private:
+      void Work(std::stop_token stopToken);
+
+      [[nodiscard]] std::string BuildDigest(const std::deque<std::string>& messages) const;
+
+      std::string name_;
+      NotificationLimits limits_;
+      Sender sender_;
+
+      std::mutex queueLock_;
+      std::condition_variable_any queueCondition_;
+      std::deque<std::string> queue_;
+      bool finished_{false};
+
+      std::atomic<uint64_t> sent_{0};
+      std::atomic<uint64_t> coalesced_{0};
+      std::atomic<uint64_t> dropped_{0};
+
+      std::unique_ptr<std::jthread> thread_;
+   };
+}
@@ -0,0 +1,232 @@
+#include "sink-fan-out.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <exception>
+
+namespace warp
+{
+   namespace
+   {
+      // A group ends its batch at this size even if more messages are waiting
+      constexpr size_t MAX_BATCH_BYTES{64u * 1024u};
+   }
+
+   SinkFanOut::SinkFanOut(size_t capacity, std::vector<SinkGroup> groups, const StyledDistSink::ThreadSetup& threadSetup)
+      : state_(std::make_shared<State>())
+   {
+      state_->slots.resize(std::bit_ceil(std::max<size_t>(capacity, 2u)));
+      state_->mask = state_->slots.size() - 1u;
+
+      for (auto& group : groups)
+      {
+         auto reader = std::make_unique<Reader>();
+         reader->group = std::move(group);
+         state_->readers.push_back(std::move(reader));
+      }
+
+      for (const auto& reader : state_->readers)
+      {
+         threads_.emplace_back([state = state_, reader = reader.get(), threadSetup] {
+            if (threadSetup) threadSetup(reader->group.suffix);
+            Work(*state, *reader);
+         });
+      }
+   }
+
+   SinkFanOut::~SinkFanOut()
+   {
+      Stop(std::chrono::steady_clock::time_point::max());
+   }
+
+   void SinkFanOut::Post(const spdlog::details::log_msg& msg, const DeferredRecord* record, bool wantsAnsi)
+   {
+      auto& slot = *Claim(std::chrono::steady_clock::time_point::max());
+      slot.kind = SlotKind::MESSAGE;
+      slot.level = msg.level;
+      slot.time = msg.time;
+      slot.source = msg.source;
+      slot.threadId = msg.thread_id;
+      slot.loggerName.assign(msg.logger_name.data(), msg.logger_name.size());
+      slot.payload.assign(msg.payload.data(), msg.payload.size());
+
+      // Parsed once here, the groups only read the result
+      slot.message.Parse(slot.payload);
+      slot.hasAnsi = wantsAnsi && !slot.message.Spans().empty();
+      if (slot.hasAnsi) slot.message.RenderAnsi(slot.ansi);
+
+      slot.hasRecord = record != nullptr;
+      if (slot.hasRecord)
+      {
+         slot.record.resize((record->size + sizeof(uint64_t) - 1u) / sizeof(uint64_t));
+         std::memcpy(slot.record.data(), record, record->size);
+      }
+
+      Publish();
+   }
+
+   bool SinkFanOut::Flush(std::chrono::steady_clock::time_point deadline)
+   {
+      auto* slot = Claim(deadline);
+      if (slot == nullptr) return false;
+
+      slot->kind = SlotKind::FLUSH;
+      Publish();
+      return true;
+   }
+
+   bool SinkFanOut::Wait(std::chrono::steady_clock::time_point deadline) const
+   {
+      const auto head = state_->head.load(std::memory_order_acquire);
+      for (const auto& reader : state_->readers)
+      {
+         while (reader->cursor.load(std::memory_order_acquire) < head)
+         {
+            if (std::chrono::steady_clock::now() >= deadline) return false;
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+         }
+      }
+      return true;
+   }
+
+   bool SinkFanOut::Stop(std::chrono::steady_clock::time_point deadline)
+   {
+      if (stopped_) return true;
+      stopped_ = true;
+
+      // Without a free slot no worker sees the stop, they are all detached below
+      if (auto* slot = Claim(deadline))
+      {
+         slot->kind = SlotKind::STOP;
+         Publish();
+      }
+
+      bool finished{true};
+      for (size_t i = 0; i < threads_.size(); ++i)
+      {
+         const auto& reader = *state_->readers[i];
+         while (!reader.finished.load(std::memory_order_acquire) && std::chrono::steady_clock::now() < deadline)
+         {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+         }
+
+         if (reader.finished.load(std::memory_order_acquire))
+         {
+            threads_[i].join();
+         }
+         else
+         {
+            threads_[i].detach();
+            finished = false;
+         }
+      }
+      threads_.clear();
+      return finished;
+   }
+
+   SinkFanOut::Slot* SinkFanOut::Claim(std::chrono::steady_clock::time_point deadline)
+   {
+      const auto head = state_->head.load(std::memory_order_relaxed);
+      const auto capacity = state_->slots.size();
+      for (const auto& reader : state_->readers)
+      {
+         auto cursor = reader->cursor.load(std::memory_order_acquire);
+         while (head - cursor >= capacity)
+         {
+            if (deadline == std::chrono::steady_clock::time_point::max())
+            {
+               reader->cursor.wait(cursor, std::memory_order_acquire);
+            }
+            else
+            {
+               // Atomic waits have no timeout, poll like Wait does
+               if (std::chrono::steady_clock::now() >= deadline) return nullptr;
+               std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            cursor = reader->cursor.load(std::memory_order_acquire);
+         }
+      }
+      return &state_->slots[head & state_->mask];
+   }
+
+   void SinkFanOut::Publish()
+   {
+      state_->head.fetch_add(1u, std::memory_order_release);
+      state_->head.notify_all();
+   }
+
+   void SinkFanOut::Work(State& state, Reader& reader)
+   {
+      auto cursor = reader.cursor.load(std::memory_order_relaxed);
+      size_t batchBytes{0};
+
+      const auto endBatch = [&reader, &batchBytes] {
+         for (const auto& entry : reader.group.sinks)
+         {
+            if (entry.batch != nullptr) entry.batch->EndBatch();
+         }
+         batchBytes = 0u;
+      };
+
+      while (true)
+      {
+         auto head = state.head.load(std::memory_order_acquire);
+         if (cursor == head)
+         {
+            state.head.wait(head, std::memory_order_acquire);
+            continue;
+         }
+
+         const auto& slot = state.slots[cursor & state.mask];
+         const auto kind = slot.kind;
+         try
+         {
+            if (kind == SlotKind::MESSAGE)
+            {
+               spdlog::details::log_msg plainMsg(slot.time,
+                                                 slot.source,
+                                                 spdlog::string_view_t(slot.loggerName.data(), slot.loggerName.size()),
+                                                 slot.level,
+                                                 spdlog::string_view_t(slot.message.Text().data(), slot.message.Text().size()));
+               plainMsg.thread_id = slot.threadId;
+
+               auto ansiMsg = plainMsg;
+               if (slot.hasAnsi) ansiMsg.payload = spdlog::string_view_t(slot.ansi.data(), slot.ansi.size());
+
+               const auto* record = slot.hasRecord ? reinterpret_cast<const DeferredRecord*>(slot.record.data()) : nullptr;
+               for (const auto& entry : reader.group.sinks)
+               {
+                  if (entry.sink->should_log(slot.level)) entry.Write(plainMsg, ansiMsg, slot.message, record);
+               }
+               batchBytes += slot.payload.size() + (slot.hasRecord ? slot.record.size() * sizeof(uint64_t) : 0u);
+            }
+            else
+            {
+               endBatch();
+               for (const auto& entry : reader.group.sinks)
+               {
+                  entry.sink->flush();
+               }
+            }
+
+            // Batch sinks hold their own copy, the slot can be reused once the cursor moves
+            if (batchBytes > 0u && (batchBytes >= MAX_BATCH_BYTES || cursor + 1u == state.head.load(std::memory_order_acquire)))
+            {
+               endBatch();
+            }
+         }
+         catch (const std::exception&)
+         {
+            // Nothing to log to from here, the message is lost for this group
+         }
+
+         reader.cursor.store(++cursor, std::memory_order_release);
+         reader.cursor.notify_all();
+
+         if (kind == SlotKind::STOP) break;
+      }
+
+      reader.finished.store(true, std::memory_order_release);
+   }
+}
\ No newline at end of file
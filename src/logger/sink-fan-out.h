@@ -0,0 +1,99 @@
+#pragma once
+
+#include "styled-dist-sink.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace warp
+{
+   // Sinks written by one worker
+   struct SinkGroup
+   {
+      std::string suffix;
+      std::vector<SinkEntry> sinks;
+   };
+
+   // Broadcast ring between the queue worker and one worker per sink group. Each
+   // group reads every message in order at its own pace, a slow group only falls
+   // behind by its own lag. The queue worker waits when a group is a full ring behind.
+   class SinkFanOut
+   {
+   public:
+      SinkFanOut(size_t capacity, std::vector<SinkGroup> groups, const StyledDistSink::ThreadSetup& threadSetup);
+      ~SinkFanOut();
+
+      // Copies the message and the deferred record it carries, if any, into the ring.
+      // Only called by one thread at a time.
+      void Post(const spdlog::details::log_msg& msg, const DeferredRecord* record, bool wantsAnsi);
+
+      // Has each group flush its sinks once it wrote the messages posted so far.
+      // Returns false if a group was still a full ring behind at the deadline.
+      bool Flush(std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max());
+
+      // Returns true once every group wrote the messages posted so far, false at the deadline
+      [[nodiscard]] bool Wait(std::chrono::steady_clock::time_point deadline) const;
+
+      // Stops the workers after they wrote everything posted. Workers still writing at
+      // the deadline are detached and false is returned, all of them if a group is
+      // still a full ring behind so the stop can not be posted.
+      bool Stop(std::chrono::steady_clock::time_point deadline);
+
+   private:
+      enum class SlotKind
+      {
+         MESSAGE,
+         FLUSH,
+         STOP
+      };
+
+      struct Slot
+      {
+         SlotKind kind{SlotKind::MESSAGE};
+         spdlog::level::level_enum level{spdlog::level::info};
+         spdlog::log_clock::time_point time;
+         spdlog::source_loc source;
+         size_t threadId{0};
+         std::string loggerName;
+         std::string payload;
+         StyledMessage message;
+         std::string ansi;
+         bool hasAnsi{false};
+         // Kept aligned for the DeferredRecord at its start
+         std::vector<uint64_t> record;
+         bool hasRecord{false};
+      };
+
+      struct Reader
+      {
+         SinkGroup group;
+         std::atomic<uint64_t> cursor{0};
+         std::atomic_bool finished{false};
+      };
+
+      // Shared with the workers, so a detached worker keeps it alive
+      struct State
+      {
+         std::vector<Slot> slots;
+         uint64_t mask{0};
+         std::atomic<uint64_t> head{0};
+         std::vector<std::unique_ptr<Reader>> readers;
+      };
+
+      static void Work(State& state, Reader& reader);
+
+      // Waits until every group is done with the next slot and returns it, or
+      // nullptr at the deadline
+      Slot* Claim(std::chrono::steady_clock::time_point deadline);
+      void Publish();
+
+      std::shared_ptr<State> state_;
+      std::vector<std::jthread> threads_;
+      bool stopped_{false};
+   };
+}
\ No newline at end of file
@@ -0,0 +1,275 @@
+#include "styled-dist-sink.h"
+
+#include "deferred-backend.h"
+#include "sink-fan-out.h"
+#include "worker-queue.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <format>
+#include <thread>
+
+namespace warp
+{
+   namespace
+   {
+      // A batch is written out at this size even if more messages are waiting
+      constexpr size_t MAX_BATCH_BYTES{64u * 1024u};
+
+      // base_sink fixes the mutex type and std::mutex has no timed lock
+      bool LockUntil(std::unique_lock<std::mutex>& lock, std::chrono::steady_clock::time_point deadline)
+      {
+         while (!lock.try_lock())
+         {
+            if (std::chrono::steady_clock::now() >= deadline) return false;
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+         }
+         return true;
+      }
+   }
+
+   const DeferredRecord* GetCarriedRecord(const spdlog::details::log_msg& msg, std::vector<uint64_t>& storage)
+   {
+      if (msg.source.filename != DEFERRED_RECORD_SOURCE || msg.payload.size() < sizeof(DeferredRecord)) return nullptr;
+
+      storage.resize((msg.payload.size() + sizeof(uint64_t) - 1u) / sizeof(uint64_t));
+      std::memcpy(storage.data(), msg.payload.data(), msg.payload.size());
+      return reinterpret_cast<const DeferredRecord*>(storage.data());
+   }
+
+   void SinkEntry::Write(const spdlog::details::log_msg& plainMsg,
+                         const spdlog::details::log_msg& ansiMsg,
+                         const StyledMessage& message,
+                         const DeferredRecord* record) const
+   {
+      if (TakesRecord(record))
+      {
+         records->LogRecord(plainMsg, *record);
+      }
+      else if (structured != nullptr)
+      {
+         structured->LogStructured(plainMsg, message);
+      }
+      else
+      {
+         sink->log(output == SinkOutput::ANSI ? ansiMsg : plainMsg);
+      }
+   }
+
+   StyledDistSink::StyledDistSink() = default;
+
+   StyledDistSink::~StyledDistSink()
+   {
+      std::lock_guard lock(mutex_);
+      EndBatch();
+      fanOut_.reset();
+   }
+
+   void StyledDistSink::AddSink(spdlog::sink_ptr sink, SinkOutput output, SinkClass sinkClass)
+   {
+      auto* structured = output == SinkOutput::STRUCTURED ? dynamic_cast<StructuredSink*>(sink.get()) : nullptr;
+      if (output == SinkOutput::STRUCTURED && structured == nullptr) output = SinkOutput::PLAIN;
+      auto* batch = dynamic_cast<BatchSink*>(sink.get());
+      auto* records = dynamic_cast<RecordSink*>(sink.get());
+      auto* throttled = dynamic_cast<ThrottledFlushSink*>(sink.get());
+
+      std::lock_guard lock(mutex_);
+      sinks_.push_back({std::move(sink), output, sinkClass, structured, batch, records, throttled});
+      RestartSinkWorkers();
+   }
+
+   void StyledDistSink::RemoveSink(const spdlog::sink_ptr& sink)
+   {
+      std::lock_guard lock(mutex_);
+      EndBatch();
+      const auto removed = std::erase_if(sinks_, [&sink](const auto& entry) {
+         return entry.sink == sink;
+      });
+      if (removed > 0u) RestartSinkWorkers();
+   }
+
+   void StyledDistSink::ClearSinks()
+   {
+      std::lock_guard lock(mutex_);
+      EndBatch();
+      sinks_.clear();
+      RestartSinkWorkers();
+   }
+
+   void StyledDistSink::SetFlushThreshold(size_t bytes)
+   {
+      std::lock_guard lock(mutex_);
+      flushThreshold_ = bytes;
+   }
+
+   void StyledDistSink::SetSinkWorkers(LogSinkWorkers workers, size_t queueSize, ThreadSetup threadSetup)
+   {
+      std::lock_guard lock(mutex_);
+      threadSetup_ = std::move(threadSetup);
+      if (workers == sinkWorkers_ && queueSize == sinkQueueSize_) return;
+
+      sinkWorkers_ = workers;
+      sinkQueueSize_ = queueSize;
+      RestartSinkWorkers();
+   }
+
+   bool StyledDistSink::WaitForSinkWorkers(std::chrono::steady_clock::time_point deadline)
+   {
+      std::unique_lock lock(mutex_, std::defer_lock);
+      if (!LockUntil(lock, deadline)) return false;
+      return !fanOut_ || fanOut_->Wait(deadline);
+   }
+
+   bool StyledDistSink::Flush(std::chrono::steady_clock::time_point deadline)
+   {
+      std::unique_lock lock(mutex_, std::defer_lock);
+      if (!LockUntil(lock, deadline)) return false;
+      return FlushSinks(deadline);
+   }
+
+   void StyledDistSink::RestartSinkWorkers()
+   {
+      // The old workers write what was posted to them before the sinks move
+      fanOut_.reset();
+      if (sinkWorkers_ == LogSinkWorkers::SHARED || sinks_.empty()) return;
+
+      std::vector<SinkGroup> groups;
+      if (sinkWorkers_ == LogSinkWorkers::PER_SINK)
+      {
+         for (size_t i = 0; i < sinks_.size(); ++i)
+         {
+            groups.push_back({std::format("-sink{}", i + 1u), {sinks_[i]}});
+         }
+      }
+      else
+      {
+         constexpr std::array<SinkClass, 3> classes{SinkClass::CONSOLE, SinkClass::FILE, SinkClass::NETWORK};
+         constexpr std::array<std::string_view, 3> suffixes{"-console", "-file", "-net"};
+         for (size_t i = 0; i < classes.size(); ++i)
+         {
+            SinkGroup group{std::string(suffixes[i]), {}};
+            for (const auto& entry : sinks_)
+            {
+               if (entry.sinkClass == classes[i]) group.sinks.push_back(entry);
+            }
+            if (!group.sinks.empty()) groups.push_back(std::move(group));
+         }
+      }
+
+      fanOut_ = std::make_unique<SinkFanOut>(sinkQueueSize_, std::move(groups), threadSetup_);
+   }
+
+   void StyledDistSink::sink_it_(const spdlog::details::log_msg& msg)
+   {
+      // Asked for every message, the worker counts down the queue depth it read
+      const bool moreQueued = MoreMessagesQueued();
+
+      const auto* record = GetCarriedRecord(msg, record_);
+
+      bool wantsAnsi{false};
+      bool wantsPlain{false};
+      bool wantsRecord{false};
+      for (const auto& entry : sinks_)
+      {
+         if (!entry.sink->should_log(msg.level)) continue;
+
+         if (entry.TakesRecord(record)) wantsRecord = true;
+         else (entry.output == SinkOutput::ANSI ? wantsAnsi : wantsPlain) = true;
+      }
+
+      if (!wantsAnsi && !wantsPlain && !wantsRecord) return;
+
+      // A record is only formatted if a sink wants its text
+      auto textMsg = msg;
+      if (record != nullptr)
+      {
+         text_.clear();
+         if (wantsAnsi || wantsPlain) FormatDeferredRecord(*record, text_);
+         textMsg.source = spdlog::source_loc{};
+         textMsg.payload = spdlog::string_view_t(text_.data(), text_.size());
+      }
+
+      if (fanOut_)
+      {
+         fanOut_->Post(textMsg, record, wantsAnsi);
+
+         pendingBytes_ += msg.payload.size();
+         if (flushThreshold_ > 0u && pendingBytes_ >= flushThreshold_) flush_();
+         return;
+      }
+
+      message_.Parse(std::string_view(textMsg.payload.data(), textMsg.payload.size()));
+
+      auto plainMsg = textMsg;
+      plainMsg.payload = spdlog::string_view_t(message_.Text().data(), message_.Text().size());
+
+      auto ansiMsg = plainMsg;
+      if (wantsAnsi && !message_.Spans().empty())
+      {
+         message_.RenderAnsi(ansi_);
+         ansiMsg.payload = spdlog::string_view_t(ansi_.data(), ansi_.size());
+      }
+
+      for (const auto& entry : sinks_)
+      {
+         if (entry.sink->should_log(msg.level)) entry.Write(plainMsg, ansiMsg, message_, record);
+      }
+
+      pendingBytes_ += msg.payload.size();
+      batchBytes_ += msg.payload.size();
+      if (flushThreshold_ > 0u && pendingBytes_ >= flushThreshold_)
+      {
+         flush_();
+      }
+      else if (batchBytes_ >= MAX_BATCH_BYTES || !moreQueued)
+      {
+         EndBatch();
+      }
+   }
+
+   void StyledDistSink::EndBatch()
+   {
+      if (batchBytes_ == 0u) return;
+      batchBytes_ = 0u;
+
+      for (const auto& entry : sinks_)
+      {
+         if (entry.batch != nullptr) entry.batch->EndBatch();
+      }
+   }
+
+   void StyledDistSink::flush_()
+   {
+      FlushSinks(std::chrono::steady_clock::time_point::max());
+   }
+
+   bool StyledDistSink::FlushSinks(std::chrono::steady_clock::time_point deadline)
+   {
+      EndBatch();
+
+      // The timer and level triggered flushes find nothing to do most of the time
+      const bool throttled = std::ranges::any_of(sinks_, [](const auto& entry) {
+         return entry.throttled != nullptr && entry.throttled->FlushPending();
+      });
+      if (pendingBytes_ == 0u && !throttled) return true;
+      pendingBytes_ = 0u;
+
+      // The workers flush once they got to the flush, behind the messages before it
+      if (fanOut_) return fanOut_->Flush(deadline);
+
+      for (const auto& entry : sinks_)
+      {
+         entry.sink->flush();
+      }
+      return true;
+   }
+
+   void StyledDistSink::set_pattern_(const std::string&)
+   {
+   }
+
+   void StyledDistSink::set_formatter_(std::unique_ptr<spdlog::formatter>)
+   {
+   }
+}
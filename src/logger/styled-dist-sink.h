@@ -0,0 +1,172 @@
+#pragma once
+
+#include "styled-message.h"
+#include "warp/log/log-deferred.h"
+
+#include <spdlog/sinks/base_sink.h>
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace warp
+{
+   enum class SinkOutput
+   {
+      ANSI,
+      PLAIN,
+      STRUCTURED
+   };
+
+   // Sinks of a class share a worker with LogSinkWorkers::PER_CLASS
+   enum class SinkClass
+   {
+      CONSOLE,
+      FILE,
+      NETWORK
+   };
+
+   // Sink that takes the parsed message with its fields instead of the plain text
+   class StructuredSink
+   {
+   public:
+      virtual ~StructuredSink() = default;
+
+      virtual void LogStructured(const spdlog::details::log_msg& msg, const StyledMessage& message) = 0;
+   };
+
+   // Sink that stores messages captured with deferred formatting as their call site
+   // and arguments instead of the formatted text
+   class RecordSink
+   {
+   public:
+      virtual ~RecordSink() = default;
+
+      virtual void LogRecord(const spdlog::details::log_msg& msg, const DeferredRecord& record) = 0;
+   };
+
+   // Source of the messages whose payload is a DeferredRecord instead of text. The
+   // logger hands deferred records over unformatted and they are only formatted
+   // here if a sink wants the text.
+   inline constexpr char DEFERRED_RECORD_SOURCE[]{"warp-deferred-record"};
+
+   // Returns the record carried by the message or nullptr for a text message. The
+   // payload is not aligned, the record is copied into the storage.
+   const DeferredRecord* GetCarriedRecord(const spdlog::details::log_msg& msg, std::vector<uint64_t>& storage);
+
+   // Sink that buffers the messages of a batch and writes them at once
+   class BatchSink
+   {
+   public:
+      virtual ~BatchSink() = default;
+
+      // Writes everything buffered since the last call
+      virtual void EndBatch() = 0;
+   };
+
+   // Sink whose flush can leave written data for later, for example to limit syncs.
+   // The styled sink flushes it on the next flush even if nothing was written since.
+   class ThrottledFlushSink
+   {
+   public:
+      virtual ~ThrottledFlushSink() = default;
+
+      // Returns if data written before the last flush still waits for it. Called
+      // from the flushing thread, so it must be safe against concurrent writes.
+      [[nodiscard]] virtual bool FlushPending() const = 0;
+   };
+
+   struct SinkEntry
+   {
+      spdlog::sink_ptr sink;
+      SinkOutput output;
+      SinkClass sinkClass;
+      StructuredSink* structured{nullptr};
+      BatchSink* batch{nullptr};
+      RecordSink* records{nullptr};
+      ThrottledFlushSink* throttled{nullptr};
+
+      // Hands the sink the variant of the message it renders. The record is set
+      // for messages captured with deferred formatting.
+      void Write(const spdlog::details::log_msg& plainMsg,
+                 const spdlog::details::log_msg& ansiMsg,
+                 const StyledMessage& message,
+                 const DeferredRecord* record) const;
+
+      // Returns if the sink takes the record instead of the text
+      [[nodiscard]] bool TakesRecord(const DeferredRecord* record) const
+      {
+         return record != nullptr && records != nullptr;
+      }
+   };
+
+   class SinkFanOut;
+
+   // Single sink attached to the spdlog logger. Splits each message into text and
+   // style spans once and hands every child sink the variant it renders, so no
+   // sink has to strip colors and colors are only rendered when a sink wants them.
+   // A batch ends when the queue worker finds no more messages waiting or the batch
+   // grew large, batch sinks write it out then. With sink workers the messages are
+   // handed to a SinkFanOut instead and the child sinks write on their own workers.
+   class StyledDistSink : public spdlog::sinks::base_sink<std::mutex>
+   {
+   public:
+      using ThreadSetup = std::function<void(const std::string& suffix)>;
+
+      StyledDistSink();
+      ~StyledDistSink() override;
+
+      // Structured sinks must implement StructuredSink
+      void AddSink(spdlog::sink_ptr sink, SinkOutput output, SinkClass sinkClass);
+      void RemoveSink(const spdlog::sink_ptr& sink);
+      void ClearSinks();
+
+      // Flushes the child sinks once this many bytes were written since the last flush
+      void SetFlushThreshold(size_t bytes);
+
+      // Moves the child sinks onto their own workers, or back onto the queue worker.
+      // The setup runs on each new worker with a suffix naming its sinks.
+      void SetSinkWorkers(LogSinkWorkers workers, size_t queueSize, ThreadSetup threadSetup);
+
+      // Waits until the sink workers wrote every message. Returns false at the deadline.
+      bool WaitForSinkWorkers(std::chrono::steady_clock::time_point deadline);
+
+      // Same as flush() but gives up at the deadline, for example when the queue worker
+      // is stuck writing to a sink or a sink worker is a full ring behind
+      bool Flush(std::chrono::steady_clock::time_point deadline);
+
+   protected:
+      void sink_it_(const spdlog::details::log_msg& msg) override;
+      void flush_() override;
+
+      // Child sinks keep their own formatters
+      void set_pattern_(const std::string& pattern) override;
+      void set_formatter_(std::unique_ptr<spdlog::formatter> sinkFormatter) override;
+
+   private:
+      void EndBatch();
+      bool FlushSinks(std::chrono::steady_clock::time_point deadline);
+
+      // Replaces the workers after the sinks or the worker setting changed
+      void RestartSinkWorkers();
+
+      std::vector<SinkEntry> sinks_;
+      StyledMessage message_;
+      std::string ansi_;
+      std::vector<uint64_t> record_;
+      std::string text_;
+
+      size_t flushThreshold_{0};
+      size_t pendingBytes_{0};
+      size_t batchBytes_{0};
+
+      LogSinkWorkers sinkWorkers_{LogSinkWorkers::SHARED};
+      size_t sinkQueueSize_{0};
+      ThreadSetup threadSetup_;
+      std::unique_ptr<SinkFanOut> fanOut_;
+   };
+}
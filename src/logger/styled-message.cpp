@@ -0,0 +1,170 @@
+#include "styled-message.h"
+
+#include "warp/utils.h"
+
+namespace warp
+{
+   namespace
+   {
+      constexpr char STYLE_ID_LAST{STYLE_ID_BASE + static_cast<char>(LogStyle::JELLYSTAT)};
+
+      bool IsFieldType(char id)
+      {
+         switch (static_cast<LogFieldType>(id))
+         {
+            case LogFieldType::STRING:
+            case LogFieldType::INT:
+            case LogFieldType::UINT:
+            case LogFieldType::FLOAT:
+            case LogFieldType::BOOL:
+               return true;
+            default:
+               return false;
+         }
+      }
+   }
+
+   std::string_view GetStyleAnsiCode(LogStyle style)
+   {
+      switch (style)
+      {
+         case LogStyle::HEADER:
+            return ANSI_CODE_LOG_HEADER;
+         case LogStyle::INFO:
+            return ANSI_CODE_LOG_INFO;
+         case LogStyle::WARNING:
+            return ANSI_CODE_LOG_WARNING;
+         case LogStyle::ERR:
+            return ANSI_CODE_LOG_ERROR;
+         case LogStyle::CRITICAL:
+            return ANSI_CODE_LOG_CRITICAL;
+         case LogStyle::DEFAULT:
+            return ANSI_CODE_LOG_DEFAULT;
+         case LogStyle::TAG:
+            return ANSI_CODE_TAG;
+         case LogStyle::STANDOUT:
+            return ANSI_CODE_STANDOUT;
+         case LogStyle::PLEX:
+            return ANSI_CODE_PLEX;
+         case LogStyle::EMBY:
+            return ANSI_CODE_EMBY;
+         case LogStyle::TAUTULLI:
+            return ANSI_CODE_TAUTULLI;
+         case LogStyle::JELLYSTAT:
+            return ANSI_CODE_JELLYSTAT;
+         default:
+            return ANSI_CODE_LOG;
+      }
+   }
+
+   void StyledMessage::Parse(std::string_view payload)
+   {
+      spans_.clear();
+      fields_.clear();
+
+      auto next = FindFirstOf(payload, 0, STYLE_MARKER, ANSII_ESCAPE);
+      if (next == std::string_view::npos)
+      {
+         // Nothing to split, the payload is the text
+         text_ = payload;
+         return;
+      }
+
+      buffer_.clear();
+      size_t pos{0};
+      bool inField{false};
+      MessageField field;
+      while (next != std::string_view::npos)
+      {
+         buffer_.append(payload.substr(pos, next - pos));
+
+         if (payload[next] == STYLE_MARKER
+             && next + 1 < payload.size()
+             && payload[next + 1] >= STYLE_ID_BASE
+             && payload[next + 1] <= STYLE_ID_LAST)
+         {
+            auto style = static_cast<LogStyle>(payload[next + 1] - STYLE_ID_BASE);
+            spans_.push_back({static_cast<uint32_t>(buffer_.size()), GetStyleAnsiCode(style)});
+            pos = next + 2;
+         }
+         else if (payload[next] == STYLE_MARKER && next + 1 < payload.size() && IsFieldType(payload[next + 1]))
+         {
+            spans_.push_back({static_cast<uint32_t>(buffer_.size()), ANSI_CODE_TAG});
+            field = {.type = static_cast<LogFieldType>(payload[next + 1]), .keyOffset = static_cast<uint32_t>(buffer_.size())};
+            inField = true;
+            pos = next + 2;
+         }
+         else if (inField && payload[next] == STYLE_MARKER && next + 1 < payload.size() && payload[next + 1] == FIELD_VALUE)
+         {
+            field.keyLength = static_cast<uint32_t>(buffer_.size()) - field.keyOffset;
+            spans_.push_back({static_cast<uint32_t>(buffer_.size()), ANSI_CODE_LOG});
+            buffer_.push_back('[');
+            field.valueOffset = static_cast<uint32_t>(buffer_.size());
+            pos = next + 2;
+         }
+         else if (inField && payload[next] == STYLE_MARKER && next + 1 < payload.size() && payload[next + 1] == FIELD_END)
+         {
+            field.valueLength = static_cast<uint32_t>(buffer_.size()) - field.valueOffset;
+            buffer_.push_back(']');
+            fields_.push_back(field);
+            inField = false;
+            pos = next + 2;
+         }
+         else if (auto length = GetAnsiiSequenceLength(payload, next); length > 0)
+         {
+            spans_.push_back({static_cast<uint32_t>(buffer_.size()), payload.substr(next, length)});
+            pos = next + length;
+         }
+         else
+         {
+            // Not a style, keep the character
+            buffer_.push_back(payload[next]);
+            pos = next + 1;
+         }
+
+         next = FindFirstOf(payload, pos, STYLE_MARKER, ANSII_ESCAPE);
+      }
+
+      buffer_.append(payload.substr(pos));
+      text_ = buffer_;
+   }
+
+   std::string_view StyledMessage::Text() const
+   {
+      return text_;
+   }
+
+   const std::vector<StyleSpan>& StyledMessage::Spans() const
+   {
+      return spans_;
+   }
+
+   const std::vector<MessageField>& StyledMessage::Fields() const
+   {
+      return fields_;
+   }
+
+   std::string_view StyledMessage::Key(const MessageField& field) const
+   {
+      return text_.substr(field.keyOffset, field.keyLength);
+   }
+
+   std::string_view StyledMessage::Value(const MessageField& field) const
+   {
+      return text_.substr(field.valueOffset, field.valueLength);
+   }
+
+   void StyledMessage::RenderAnsi(std::string& out) const
+   {
+      out.clear();
+
+      size_t pos{0};
+      for (const auto& span : spans_)
+      {
+         out.append(text_.substr(pos, span.offset - pos));
+         out.append(span.ansiCode);
+         pos = span.offset;
+      }
+      out.append(text_.substr(pos));
+   }
+}
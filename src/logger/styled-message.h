@@ -0,0 +1,57 @@
+#pragma once
+
+#include "warp/log/log-types.h"
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace warp
+{
+   // Style change at a position of the plain message text
+   struct StyleSpan
+   {
+      uint32_t offset{0};
+      std::string_view ansiCode;
+   };
+
+   // Typed key/value field of a message. Offsets point into the plain text.
+   struct MessageField
+   {
+      LogFieldType type{LogFieldType::STRING};
+      uint32_t keyOffset{0};
+      uint32_t keyLength{0};
+      uint32_t valueOffset{0};
+      uint32_t valueLength{0};
+   };
+
+   // A log message split into its plain text and the style spans embedded in it.
+   // Style codes and raw ansi sequences are both turned into spans, fields into
+   // key[value] text with the key styled as a tag.
+   class StyledMessage
+   {
+   public:
+      // Parses the payload. The payload must outlive the message.
+      void Parse(std::string_view payload);
+
+      [[nodiscard]] std::string_view Text() const;
+      [[nodiscard]] const std::vector<StyleSpan>& Spans() const;
+      [[nodiscard]] const std::vector<MessageField>& Fields() const;
+
+      [[nodiscard]] std::string_view Key(const MessageField& field) const;
+      [[nodiscard]] std::string_view Value(const MessageField& field) const;
+
+      // Writes the text with the spans rendered as ansi codes
+      void RenderAnsi(std::string& out) const;
+
+   private:
+      std::string_view text_;
+      std::string buffer_;
+      std::vector<StyleSpan> spans_;
+      std::vector<MessageField> fields_;
+   };
+
+   // Returns the ansi code the console uses for the style
+   std::string_view GetStyleAnsiCode(LogStyle style);
+}
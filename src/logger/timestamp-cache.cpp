@@ -0,0 +1,36 @@
+#include "timestamp-cache.h"
+
+#include <spdlog/details/os.h>
+
+#include <array>
+#include <ctime>
+#include <format>
+
+namespace warp
+{
+   namespace
+   {
+      constexpr size_t TIMESTAMP_LENGTH{19u};
+
+      struct TimestampCache
+      {
+         std::time_t second{-1};
+         std::array<char, TIMESTAMP_LENGTH> text{};
+      };
+
+      thread_local TimestampCache cache;
+   }
+
+   std::string_view GetCachedTimestamp(spdlog::log_clock::time_point time)
+   {
+      const auto second = spdlog::log_clock::to_time_t(time);
+      if (second != cache.second)
+      {
+         const auto tm = spdlog::details::os::localtime(second);
+         std::format_to_n(cache.text.data(), cache.text.size(), "{:02}/{:02}/{:04} {:02}:{:02}:{:02}",
+                          tm.tm_mon + 1, tm.tm_mday, tm.tm_year + 1900, tm.tm_hour, tm.tm_min, tm.tm_sec);
+         cache.second = second;
+      }
+      return {cache.text.data(), cache.text.size()};
+   }
+}
\ No newline at end of file
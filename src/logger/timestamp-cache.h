@@ -0,0 +1,13 @@
+#pragma once
+
+#include <spdlog/common.h>
+
+#include <string_view>
+
+namespace warp
+{
+   // Returns the time as "%m/%d/%Y %T" in local time. The text is rendered once per
+   // second per thread and shared by every formatter running on that thread. The
+   // view stays valid until the next call on the same thread.
+   std::string_view GetCachedTimestamp(spdlog::log_clock::time_point time);
+}
\ No newline at end of file
@@ -0,0 +1,38 @@
+#include "worker-queue.h"
+
+#include <spdlog/async.h>
+
+namespace warp
+{
+   namespace
+   {
+      thread_local const std::atomic<spdlog::details::thread_pool*>* workerQueue{nullptr};
+      thread_local bool soleWorker{false};
+
+      // Messages known to be queued behind the current one, only counted by a sole worker
+      thread_local size_t queuedAhead{0u};
+   }
+
+   void SetWorkerQueue(const std::atomic<spdlog::details::thread_pool*>* queue, bool sole)
+   {
+      workerQueue = queue;
+      soleWorker = sole;
+      queuedAhead = 0u;
+   }
+
+   bool MoreMessagesQueued()
+   {
+      if (workerQueue == nullptr) return false;
+
+      if (queuedAhead > 1u)
+      {
+         --queuedAhead;
+         return true;
+      }
+
+      auto* pool = workerQueue->load(std::memory_order_acquire);
+      const size_t depth = pool != nullptr ? pool->queue_size() : 0u;
+      if (soleWorker && depth > 0u) queuedAhead = depth - 1u;
+      return depth > 0u;
+   }
+}
\ No newline at end of file
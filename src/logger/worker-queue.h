@@ -0,0 +1,22 @@
+#pragma once
+
+#include <atomic>
+
+namespace spdlog::details
+{
+   class thread_pool;
+}
+
+namespace warp
+{
+   // Called by each queue worker when it starts. The pointer is set once the pool exists.
+   // The sole worker of a pool takes every queued message itself.
+   void SetWorkerQueue(const std::atomic<spdlog::details::thread_pool*>* queue, bool soleWorker);
+
+   // Returns if more messages wait in the queue of the calling worker, so a sink can
+   // keep buffering. False on any other thread. Called once per message: a sole worker
+   // counts down the depth it read instead of locking the queue for every message.
+   // The depth also counts flush and terminate entries, so the last message of the
+   // count reads the real depth again.
+   bool MoreMessagesQueued();
+}
\ No newline at end of file
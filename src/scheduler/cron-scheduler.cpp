@@ -56,14 +56,14 @@ namespace warp
       bool success = cronTasks_.add_schedule(task.name, expr, [task, tagTaskName, tagCronName]([[maybe_unused]] auto& info) {
          try
          {
-            log::Trace("Cron Scheduler: Running {} with {}", tagTaskName, tagCronName);
+            WARP_LOG_TRACE("Cron Scheduler: Running {} with {}", tagTaskName, tagCronName);
             task.func();
          }
          catch (const std::exception& e)
          {
             log::Error("Cron Scheduler: {} caught {}",
                        tagTaskName,
-                       GetTag("exception", e.what()));
+                       Tag("exception", e.what()));
          }
       });
 
@@ -0,0 +1,305 @@
+// Renders log files written by the binary file sink as DEFAULT_PATTERN text.
+// Usage: warp-log-decode <file>...
+
+#include "logger/binary-log-format.h"
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <ctime>
+#include <format>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <variant>
+#include <vector>
+
+namespace
+{
+   // spdlog level names as %l prints them
+   constexpr std::array<std::string_view, 7> LEVEL_NAMES{"trace", "debug", "info", "warning", "error", "critical", "off"};
+
+   std::string_view LevelName(uint8_t level)
+   {
+      return level < LEVEL_NAMES.size() ? LEVEL_NAMES[level] : "unknown";
+   }
+
+   // Matches the "%m/%d/%Y %T" part of DEFAULT_PATTERN
+   std::string FormatTime(int64_t nanoseconds)
+   {
+      const auto time = std::chrono::system_clock::to_time_t(std::chrono::system_clock::time_point(
+         std::chrono::duration_cast<std::chrono::system_clock::duration>(std::chrono::nanoseconds(nanoseconds))));
+
+      std::tm local{};
+#if defined(_WIN32)
+      localtime_s(&local, &time);
+#else
+      localtime_r(&time, &local);
+#endif
+      std::array<char, 32> buffer{};
+      const auto length = std::strftime(buffer.data(), buffer.size(), "%m/%d/%Y %H:%M:%S", &local);
+      return std::string(buffer.data(), length);
+   }
+
+   void PrintLine(int64_t time, uint8_t level, std::string_view text)
+   {
+      std::printf("%s [%.*s] %.*s\n",
+                  FormatTime(time).c_str(),
+                  static_cast<int>(LevelName(level).size()), LevelName(level).data(),
+                  static_cast<int>(text.size()), text.data());
+   }
+
+   bool ReadText(std::string_view data, size_t& pos, std::string_view& text)
+   {
+      uint64_t length{0};
+      if (!warp::ReadVarint(data, pos, length) || length > data.size() - pos) return false;
+
+      text = data.substr(pos, length);
+      pos += length;
+      return true;
+   }
+
+   using Arg = std::variant<bool, char, int64_t, uint64_t, float, double, std::string>;
+
+   bool ReadArg(std::string_view data, size_t& pos, Arg& arg)
+   {
+      if (pos >= data.size()) return false;
+
+      const auto type = static_cast<warp::BinaryArgType>(data[pos++]);
+      const auto byte = pos < data.size() ? data[pos] : '\0';
+
+      uint64_t value{0};
+      std::string_view text;
+      switch (type)
+      {
+         case warp::BinaryArgType::BOOL:
+            arg = byte != 0;
+            return pos++ < data.size();
+         case warp::BinaryArgType::CHAR:
+            arg = byte;
+            return pos++ < data.size();
+         case warp::BinaryArgType::INT8:
+            arg = static_cast<int64_t>(static_cast<int8_t>(byte));
+            return pos++ < data.size();
+         case warp::BinaryArgType::UINT8:
+            arg = static_cast<uint64_t>(static_cast<uint8_t>(byte));
+            return pos++ < data.size();
+         case warp::BinaryArgType::INT16:
+         case warp::BinaryArgType::INT32:
+         case warp::BinaryArgType::INT64:
+            if (!warp::ReadVarint(data, pos, value)) return false;
+            arg = warp::ZigZagDecode(value);
+            return true;
+         case warp::BinaryArgType::UINT16:
+         case warp::BinaryArgType::UINT32:
+         case warp::BinaryArgType::UINT64:
+            if (!warp::ReadVarint(data, pos, value)) return false;
+            arg = value;
+            return true;
+         case warp::BinaryArgType::FLOAT:
+         {
+            float number{0};
+            if (!warp::ReadFloat(data, pos, number)) return false;
+            arg = number;
+            return true;
+         }
+         case warp::BinaryArgType::DOUBLE:
+         {
+            double number{0};
+            if (!warp::ReadFloat(data, pos, number)) return false;
+            arg = number;
+            return true;
+         }
+         case warp::BinaryArgType::STRING:
+            if (!ReadText(data, pos, text)) return false;
+            arg = std::string(text);
+            return true;
+      }
+      return false;
+   }
+
+   // Formats one argument with the spec of its replacement field
+   void AppendArg(std::string& line, const Arg& arg, std::string_view spec)
+   {
+      try
+      {
+         const auto field = std::string("{").append(spec).append("}");
+         std::visit([&](const auto& value) { std::vformat_to(std::back_inserter(line), field, std::make_format_args(value)); }, arg);
+      }
+      catch (const std::exception&)
+      {
+         line.append("{?}");
+      }
+   }
+
+   // Renders the std::format string of a template with the arguments of a message
+   void Render(std::string& line, std::string_view format, const std::vector<Arg>& args)
+   {
+      size_t nextArg{0};
+      size_t pos{0};
+      while (pos < format.size())
+      {
+         const auto c = format[pos++];
+         if (c == '}')
+         {
+            if (pos < format.size() && format[pos] == '}') ++pos;
+            line.push_back(c);
+            continue;
+         }
+         if (c != '{')
+         {
+            line.push_back(c);
+            continue;
+         }
+         if (pos < format.size() && format[pos] == '{')
+         {
+            line.push_back(c);
+            ++pos;
+            continue;
+         }
+
+         const auto end = format.find('}', pos);
+         if (end == std::string_view::npos)
+         {
+            line.append(format.substr(pos - 1u));
+            return;
+         }
+
+         // Replacement field: optional argument index, then an optional spec
+         const auto field = format.substr(pos, end - pos);
+         pos = end + 1u;
+
+         const auto colon = field.find(':');
+         const auto index = field.substr(0, colon);
+         const auto spec = colon == std::string_view::npos ? std::string_view{} : field.substr(colon);
+
+         size_t argIndex{nextArg++};
+         if (!index.empty())
+         {
+            argIndex = 0;
+            for (const auto digit : index)
+            {
+               if (digit < '0' || digit > '9')
+               {
+                  argIndex = args.size();
+                  break;
+               }
+               argIndex = argIndex * 10u + static_cast<size_t>(digit - '0');
+            }
+         }
+
+         // Nested replacement fields in the spec are not supported
+         if (argIndex >= args.size() || spec.find('{') != std::string_view::npos)
+         {
+            line.append("{?}");
+            continue;
+         }
+         AppendArg(line, args[argIndex], spec);
+      }
+   }
+
+   bool Damaged(size_t offset)
+   {
+      std::fprintf(stderr, "Stopped at a damaged record at offset %zu\n", offset);
+      return false;
+   }
+
+   // Returns false if the file is not a binary log or ends inside a record
+   bool Decode(std::string_view data)
+   {
+      if (data.size() < warp::BINARY_LOG_MAGIC.size() + 1u
+          || data.substr(0, warp::BINARY_LOG_MAGIC.size()) != warp::BINARY_LOG_MAGIC
+          || static_cast<uint8_t>(data[warp::BINARY_LOG_MAGIC.size()]) != warp::BINARY_LOG_VERSION)
+      {
+         std::fprintf(stderr, "Not a warp binary log or an unsupported version\n");
+         return false;
+      }
+
+      std::vector<std::string> templates;
+      std::vector<Arg> args;
+      std::string line;
+      int64_t time{0};
+      size_t pos{warp::BINARY_LOG_MAGIC.size() + 1u};
+      while (pos < data.size())
+      {
+         const auto recordStart = pos;
+         const auto kindByte = static_cast<uint8_t>(data[pos++]);
+         const auto kind = static_cast<warp::BinaryRecordKind>(kindByte & warp::BINARY_LOG_KIND_MASK);
+         const auto level = static_cast<uint8_t>(kindByte & warp::BINARY_LOG_LEVEL_MASK);
+
+         uint64_t value{0};
+         std::string_view text;
+         if (kind == warp::BinaryRecordKind::TEMPLATE)
+         {
+            if (!warp::ReadVarint(data, pos, value) || !ReadText(data, pos, text)) return Damaged(recordStart);
+            if (value >= templates.size()) templates.resize(value + 1u);
+            templates[value] = std::string(text);
+            continue;
+         }
+
+         if (!warp::ReadVarint(data, pos, value)) return Damaged(recordStart);
+         time += warp::ZigZagDecode(value);
+
+         if (kind == warp::BinaryRecordKind::TEXT)
+         {
+            if (!ReadText(data, pos, text)) return Damaged(recordStart);
+            PrintLine(time, level, text);
+            continue;
+         }
+
+         if (kind != warp::BinaryRecordKind::MESSAGE) return Damaged(recordStart);
+
+         uint64_t id{0};
+         uint64_t count{0};
+         std::string_view header;
+         if (!warp::ReadVarint(data, pos, id) || id >= templates.size()
+             || !ReadText(data, pos, header)
+             || !warp::ReadVarint(data, pos, count)) return Damaged(recordStart);
+
+         args.resize(count);
+         for (auto& arg : args)
+         {
+            if (!ReadArg(data, pos, arg)) return Damaged(recordStart);
+         }
+
+         line.clear();
+         if (!header.empty())
+         {
+            line.append(header);
+            line.append(": ");
+         }
+         Render(line, templates[id], args);
+
+         PrintLine(time, level, line);
+      }
+
+      return true;
+   }
+}
+
+int main(int argc, char** argv)
+{
+   if (argc < 2)
+   {
+      std::fprintf(stderr, "Usage: %s <file>...\n", argv[0]);
+      return 2;
+   }
+
+   int result{0};
+   for (int i = 1; i < argc; ++i)
+   {
+      std::ifstream file(argv[i], std::ios::binary);
+      if (!file)
+      {
+         std::fprintf(stderr, "Failed to open %s\n", argv[i]);
+         result = 1;
+         continue;
+      }
+
+      const std::string data{std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+      if (!Decode(data)) result = 1;
+   }
+   return result;
+}
\ No newline at end of file